@@ -0,0 +1,210 @@
+#pragma once
+
+// Paquete de assets (.pak): texturas ya horneadas, audio y niveles en un
+// solo archivo. Little-endian.
+//
+//   BundleHeader
+//   BundleEntry[entryCount]  ordenadas por nombre (busqueda binaria)
+//   datos                    cada entrada alineada a 16 bytes
+//
+// Datos de cada tipo de entrada:
+//   BUNDLE_TEXTURE   BundleTexture y despues size * size pixeles RGBA
+//   BUNDLE_AUDIO     el archivo de audio tal cual (mp3, wav, ogg...); se
+//                    decodifica desde memoria
+//   BUNDLE_LEVEL     un archivo .lvl tal cual (ver level_format.h)
+//
+// El paquete se abre con mmap, igual que los niveles: abrirlo solo lee la
+// cabecera y el indice, y los datos se cargan cuando se usan.
+
+#include "raylib.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+
+const uint32_t BUNDLE_FORMAT_VERSION = 1;
+const char* const ASSET_BUNDLE_FILE = "assets.pak";   // Paquete del juego, en el directorio de trabajo
+const int BUNDLE_NAME_SIZE = 48;
+const uint64_t BUNDLE_ALIGNMENT = 16;
+
+enum BundleEntryType : uint32_t {
+    BUNDLE_TEXTURE = 1,
+    BUNDLE_AUDIO = 2,
+    BUNDLE_LEVEL = 3
+};
+
+struct BundleHeader {
+    char magic[4];          // "RCPK"
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+};
+
+struct BundleEntry {
+    char name[BUNDLE_NAME_SIZE];    // Terminado en cero, por ejemplo "levels/level1.lvl"
+    uint32_t type;                  // BundleEntryType
+    uint32_t reserved;
+    uint64_t offset;                // Desde el inicio del archivo
+    uint64_t size;
+};
+
+struct BundleTexture {
+    uint32_t size;          // Lado en pixeles
+    uint32_t reserved;
+};
+
+static_assert(sizeof(BundleHeader) == 16, "BundleHeader debe medir 16 bytes");
+static_assert(sizeof(BundleEntry) == 72, "BundleEntry debe medir 72 bytes");
+static_assert(sizeof(BundleTexture) == 8, "BundleTexture debe medir 8 bytes");
+
+class AssetBundle {
+public:
+    // Abre y valida el indice del paquete. Despues de abrirlo se puede leer
+    // desde varios hilos a la vez.
+    bool Open(const char* path, std::string* error) {
+        Close();
+        if (!file.Open(path)) {
+            if (error) *error = std::string("no se pudo abrir ") + path;
+            return false;
+        }
+
+        size_t size = file.Size();
+        const BundleHeader* header = (const BundleHeader*)file.Data();
+        const BundleEntry* list = (const BundleEntry*)(file.Data() + sizeof(BundleHeader));
+        const char* problem = NULL;
+        if (size < sizeof(BundleHeader) || memcmp(header->magic, "RCPK", 4) != 0) {
+            problem = "no es un paquete de assets";
+        } else if (header->version != BUNDLE_FORMAT_VERSION) {
+            problem = "version de formato no soportada";
+        } else if ((size - sizeof(BundleHeader)) / sizeof(BundleEntry) < header->entryCount) {
+            problem = "indice incompleto";
+        } else {
+            for (uint32_t i = 0; i < header->entryCount && problem == NULL; i++) {
+                const BundleEntry& entry = list[i];
+                if (memchr(entry.name, 0, BUNDLE_NAME_SIZE) == NULL) {
+                    problem = "nombre de entrada invalido";
+                } else if (i > 0 && strcmp(list[i - 1].name, entry.name) >= 0) {
+                    problem = "indice desordenado";
+                } else if (entry.offset % BUNDLE_ALIGNMENT != 0 || entry.offset > size || entry.size > size - entry.offset) {
+                    problem = "entrada fuera del archivo";
+                } else if (entry.type == BUNDLE_TEXTURE && !ValidTexture(entry)) {
+                    problem = "textura incompleta";
+                }
+            }
+        }
+        if (problem != NULL) {
+            if (error) *error = std::string(path) + ": " + problem;
+            Close();
+            return false;
+        }
+
+        bundlePath = path;
+        entries = list;
+        entryCount = header->entryCount;
+        return true;
+    }
+
+    void Close() {
+        file.Close();
+        bundlePath.clear();
+        entries = nullptr;
+        entryCount = 0;
+    }
+
+    bool IsOpen() const { return file.IsOpen(); }
+    const std::string& Path() const { return bundlePath; }
+    int EntryCount() const { return (int)entryCount; }
+
+    // Entrada con ese nombre y tipo, o nullptr (tambien si no hay paquete)
+    const BundleEntry* Find(const char* name, uint32_t type) const {
+        const BundleEntry* end = entries + entryCount;
+        const BundleEntry* entry = std::lower_bound(entries, end, name,
+            [](const BundleEntry& e, const char* key) { return strcmp(e.name, key) < 0; });
+        if (entry == end || strcmp(entry->name, name) != 0 || entry->type != type) return nullptr;
+        return entry;
+    }
+
+    const unsigned char* Data(const BundleEntry& entry) const { return file.Data() + entry.offset; }
+
+    // Pixeles de la textura name si esta en el paquete con lado size
+    const Color* Texture(const char* name, int size) const {
+        const BundleEntry* entry = Find(name, BUNDLE_TEXTURE);
+        if (entry == nullptr) return nullptr;
+        const BundleTexture* texture = (const BundleTexture*)Data(*entry);
+        if ((int)texture->size != size) return nullptr;
+        return (const Color*)(texture + 1);
+    }
+
+private:
+    bool ValidTexture(const BundleEntry& entry) const {
+        if (entry.size < sizeof(BundleTexture)) return false;
+        const BundleTexture* texture = (const BundleTexture*)(file.Data() + entry.offset);
+        uint64_t pixels = (uint64_t)texture->size * texture->size;
+        return texture->size <= 4096 && (entry.size - sizeof(BundleTexture)) / sizeof(Color) >= pixels;
+    }
+
+    MappedFile file;
+    std::string bundlePath;
+    const BundleEntry* entries = nullptr;
+    uint32_t entryCount = 0;
+};
+
+// Entrada para escribir un paquete
+struct BundleSource {
+    std::string name;
+    uint32_t type;
+    std::vector<unsigned char> data;
+};
+
+// Datos de una entrada BUNDLE_TEXTURE
+inline std::vector<unsigned char> BundleTextureData(const Color* pixels, int size) {
+    BundleTexture texture = {(uint32_t)size, 0};
+    std::vector<unsigned char> data(sizeof(texture) + (size_t)size * size * sizeof(Color));
+    memcpy(data.data(), &texture, sizeof(texture));
+    memcpy(data.data() + sizeof(texture), pixels, (size_t)size * size * sizeof(Color));
+    return data;
+}
+
+inline bool WriteAssetBundle(const char* path, std::vector<BundleSource> sources) {
+    std::sort(sources.begin(), sources.end(),
+              [](const BundleSource& a, const BundleSource& b) { return a.name < b.name; });
+    for (size_t i = 0; i < sources.size(); i++) {
+        if (sources[i].name.size() >= (size_t)BUNDLE_NAME_SIZE) return false;
+        if (i > 0 && sources[i].name == sources[i - 1].name) return false;
+    }
+
+    BundleHeader header = {};
+    memcpy(header.magic, "RCPK", 4);
+    header.version = BUNDLE_FORMAT_VERSION;
+    header.entryCount = (uint32_t)sources.size();
+
+    std::vector<BundleEntry> entries(sources.size());
+    uint64_t offset = sizeof(BundleHeader) + sources.size() * sizeof(BundleEntry);
+    for (size_t i = 0; i < sources.size(); i++) {
+        offset = (offset + BUNDLE_ALIGNMENT - 1) & ~(BUNDLE_ALIGNMENT - 1);
+        BundleEntry& entry = entries[i];
+        memset(&entry, 0, sizeof(entry));
+        memcpy(entry.name, sources[i].name.c_str(), sources[i].name.size());
+        entry.type = sources[i].type;
+        entry.offset = offset;
+        entry.size = sources[i].data.size();
+        offset += entry.size;
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) return false;
+    static const unsigned char padding[BUNDLE_ALIGNMENT] = {0};
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              (entries.empty() || fwrite(entries.data(), sizeof(BundleEntry), entries.size(), file) == entries.size());
+    uint64_t written = sizeof(BundleHeader) + entries.size() * sizeof(BundleEntry);
+    for (size_t i = 0; i < sources.size() && ok; i++) {
+        size_t pad = (size_t)(entries[i].offset - written);
+        const std::vector<unsigned char>& data = sources[i].data;
+        ok = fwrite(padding, 1, pad, file) == pad && fwrite(data.data(), 1, data.size(), file) == data.size();
+        written = entries[i].offset + data.size();
+    }
+    return fclose(file) == 0 && ok;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+// Carga de assets en segundo plano.
+//
+// Load encola una tarea de carga (armar texturas, decodificar, abrir
+// niveles...) para un grupo de hilos propio y devuelve un future que queda
+// listo cuando termina; asi el menu se dibuja mientras se carga. Quien
+// necesita el asset espera su future (por ejemplo, al entrar a un nivel).
+// WhenReady registra una funcion que corre en el hilo principal, dentro de
+// Poll, cuando el future esta listo: para lo que solo puede hacer ese hilo
+// (subir texturas a la GPU, cambiar de pantalla).
+//
+// Las tareas no deben tocar estado que el hilo principal use mientras
+// tanto; las que escriben globales del render se esperan antes de dibujar.
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class AssetLoader {
+public:
+    explicit AssetLoader(int numThreads) {
+        if (numThreads < 1) numThreads = 1;
+        for (int i = 0; i < numThreads; i++) {
+            workers.emplace_back([this] { WorkerLoop(); });
+        }
+    }
+
+    // Termina las tareas pendientes antes de salir
+    ~AssetLoader() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // Encola task; las tareas corren en paralelo, en el orden en que se
+    // encolaron
+    std::shared_future<void> Load(std::function<void()> task) {
+        std::packaged_task<void()> job(std::move(task));
+        std::shared_future<void> future = job.get_future().share();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(std::move(job));
+        }
+        wake.notify_one();
+        return future;
+    }
+
+    // Solo el hilo principal: callback corre en Poll cuando future este listo
+    void WhenReady(std::shared_future<void> future, std::function<void()> callback) {
+        callbacks.push_back({std::move(future), std::move(callback)});
+    }
+
+    // Solo el hilo principal, una vez por frame: corre los callbacks cuyos
+    // futures ya estan listos
+    void Poll() {
+        for (size_t i = 0; i < callbacks.size();) {
+            if (callbacks[i].future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                i++;
+                continue;
+            }
+            std::function<void()> callback = std::move(callbacks[i].callback);
+            callbacks.erase(callbacks.begin() + i);
+            callback();
+        }
+    }
+
+private:
+    struct Callback {
+        std::shared_future<void> future;
+        std::function<void()> callback;
+    };
+
+    void WorkerLoop() {
+        while (true) {
+            std::packaged_task<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (queue.empty()) return;
+                job = std::move(queue.front());
+                queue.pop_front();
+            }
+            job();
+        }
+    }
+
+    std::vector<Callback> callbacks;    // Solo el hilo principal
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::packaged_task<void()>> queue;
+    bool stopping = false;
+    std::vector<std::thread> workers;   // Ultimo: arranca con todo lo demas ya construido
+};
@@ -0,0 +1,139 @@
+#pragma once
+
+// Hilo de audio: es dueño del dispositivo, de la musica y de los efectos.
+//
+// El juego no llama a raylib para el audio: manda comandos (tocar, parar,
+// volumen) por una cola sin bloqueos y sigue, asi que el hilo de render
+// nunca espera al audio. El hilo de audio abre el dispositivo, decodifica
+// los efectos completos en memoria al arrancar (LoadSound) y alimenta el
+// stream de musica cada pocos milisegundos, asi que un frame lento no deja
+// la musica sin datos. Los archivos que estan en el paquete de assets se
+// decodifican desde ahi, sin leer el archivo suelto.
+
+#include "raylib.h"
+#include "asset_bundle.h"
+#include "spsc_queue.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+const int AUDIO_POLL_MS = 5;   // Cada cuanto se atienden comandos y se alimenta la musica
+
+enum AudioCommandType {
+    AUDIO_PLAY_SOUND,
+    AUDIO_STOP_SOUND,
+    AUDIO_SOUND_VOLUME,
+    AUDIO_PLAY_MUSIC,
+    AUDIO_STOP_MUSIC,
+    AUDIO_MUSIC_VOLUME
+};
+
+struct AudioCommand {
+    AudioCommandType type;
+    int sound;      // Indice del efecto (solo comandos de efectos)
+    float volume;   // Solo comandos de volumen
+};
+
+class AudioThread {
+public:
+    // soundFiles son los efectos (el indice de cada uno es su id);
+    // musicFile puede ser vacio. Si bundle no es nullptr debe seguir
+    // abierto mientras exista el hilo: la musica se lee de ahi al tocarla.
+    AudioThread(std::vector<std::string> soundFiles, std::string musicFile, const AssetBundle* bundle = nullptr)
+        : soundPaths(std::move(soundFiles)), musicPath(std::move(musicFile)), bundle(bundle),
+          ready(readyPromise.get_future().share()), worker([this] { Run(); }) {}
+
+    ~AudioThread() {
+        stopping.store(true, std::memory_order_release);
+        worker.join();
+    }
+
+    AudioThread(const AudioThread&) = delete;
+    AudioThread& operator=(const AudioThread&) = delete;
+
+    // Comandos desde el hilo del juego (un solo productor). Si la cola esta
+    // llena el comando se descarta en vez de esperar.
+    bool Play(int sound) { return commands.Push({AUDIO_PLAY_SOUND, sound, 0.0f}); }
+    bool Stop(int sound) { return commands.Push({AUDIO_STOP_SOUND, sound, 0.0f}); }
+    bool SetVolume(int sound, float volume) { return commands.Push({AUDIO_SOUND_VOLUME, sound, volume}); }
+    bool PlayMusic() { return commands.Push({AUDIO_PLAY_MUSIC, 0, 0.0f}); }
+    bool StopMusic() { return commands.Push({AUDIO_STOP_MUSIC, 0, 0.0f}); }
+    bool SetMusicVolume(float volume) { return commands.Push({AUDIO_MUSIC_VOLUME, 0, volume}); }
+
+    // Listo cuando el dispositivo esta abierto y el audio cargado (los
+    // comandos anteriores se atienden en ese momento)
+    std::shared_future<void> Ready() const { return ready; }
+
+private:
+    // Entrada del paquete para un archivo de audio, o nullptr
+    const BundleEntry* BundleAudio(const std::string& path) const {
+        return bundle != nullptr ? bundle->Find(path.c_str(), BUNDLE_AUDIO) : nullptr;
+    }
+
+    Sound LoadEffect(const std::string& path) const {
+        const BundleEntry* entry = BundleAudio(path);
+        if (entry == nullptr) return LoadSound(path.c_str());
+        Wave wave = LoadWaveFromMemory(GetFileExtension(path.c_str()), bundle->Data(*entry), (int)entry->size);
+        Sound sound = LoadSoundFromWave(wave);
+        UnloadWave(wave);
+        return sound;
+    }
+
+    Music LoadMusic(const std::string& path) const {
+        const BundleEntry* entry = BundleAudio(path);
+        if (entry == nullptr) return LoadMusicStream(path.c_str());
+        return LoadMusicStreamFromMemory(GetFileExtension(path.c_str()), bundle->Data(*entry), (int)entry->size);
+    }
+
+    void Run() {
+        InitAudioDevice();
+
+        std::vector<Sound> sounds;
+        for (const std::string& path : soundPaths) {
+            sounds.push_back(LoadEffect(path));
+            if (sounds.back().stream.buffer == NULL) TraceLog(LOG_WARNING, "No se pudo cargar %s", path.c_str());
+        }
+        Music music = {};
+        if (!musicPath.empty()) {
+            music = LoadMusic(musicPath);
+            if (music.stream.buffer == NULL) TraceLog(LOG_WARNING, "No se pudo cargar %s", musicPath.c_str());
+        }
+        bool hasMusic = music.stream.buffer != NULL;
+        readyPromise.set_value();
+
+        while (!stopping.load(std::memory_order_acquire)) {
+            AudioCommand command;
+            while (commands.Pop(command)) {
+                bool validSound = command.sound >= 0 && command.sound < (int)sounds.size() && sounds[command.sound].stream.buffer != NULL;
+                switch (command.type) {
+                    case AUDIO_PLAY_SOUND: if (validSound) ::PlaySound(sounds[command.sound]); break;
+                    case AUDIO_STOP_SOUND: if (validSound) ::StopSound(sounds[command.sound]); break;
+                    case AUDIO_SOUND_VOLUME: if (validSound) ::SetSoundVolume(sounds[command.sound], command.volume); break;
+                    case AUDIO_PLAY_MUSIC: if (hasMusic) PlayMusicStream(music); break;
+                    case AUDIO_STOP_MUSIC: if (hasMusic) StopMusicStream(music); break;
+                    case AUDIO_MUSIC_VOLUME: if (hasMusic) ::SetMusicVolume(music, command.volume); break;
+                }
+            }
+            if (hasMusic) UpdateMusicStream(music);
+            std::this_thread::sleep_for(std::chrono::milliseconds(AUDIO_POLL_MS));
+        }
+
+        if (hasMusic) UnloadMusicStream(music);
+        for (Sound& sound : sounds) {
+            if (sound.stream.buffer != NULL) UnloadSound(sound);
+        }
+        CloseAudioDevice();
+    }
+
+    std::vector<std::string> soundPaths;
+    std::string musicPath;
+    const AssetBundle* bundle;
+    std::promise<void> readyPromise;
+    std::shared_future<void> ready;
+    SpscQueue<AudioCommand, 64> commands;
+    std::atomic<bool> stopping{false};
+    std::thread worker;     // Ultimo: arranca con todo lo demas ya construido
+};
@@ -0,0 +1,147 @@
+#pragma once
+
+// Render por lotes sin ventana: muchas vistas chicas en primera persona por
+// llamada, por ejemplo para las observaciones de agentes automaticos.
+//
+// BatchRenderer no usa el jugador, el mapa ni el framebuffer globales:
+// recibe un mapa, sus sprites y N poses de camara, y escribe N imagenes RGB
+// y N mapas de profundidad en buffers contiguos de quien llama. Del estado
+// global solo lee lo que no cambia mientras se juega: las texturas
+// (wallAtlas, spriteTextures) y rayKernel.
+//
+// Cada vista se renderiza entera en un hilo, con las mismas funciones que
+// RenderScene, sobre memoria de trabajo propia de ese hilo que se reserva
+// la primera vez y despues se reusa: en regimen no se reserva memoria. Las
+// vistas se reparten entre los hilos de un ThreadPool. Se puede llamar a
+// Render desde varios hilos a la vez si cada llamada usa otro pool (o
+// ninguno), porque ParallelFor no es reentrante.
+
+#include "raycaster.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Pose de una vista en unidades de mundo
+struct ViewPose {
+    float x, y;
+    float angle;
+};
+
+// Salida de un lote: frame mayor y dentro de cada frame fila mayor
+struct BatchFrames {
+    uint8_t* rgb;       // count * width * height * 3 bytes
+    float* depth;       // count * width * height; nullptr si no hace falta
+};
+
+// Memoria de trabajo de un hilo para renderizar una vista
+struct BatchScratch {
+    std::vector<Color> pixels;
+    std::vector<float> columnDepth;
+    DepthPyramid pyramid;
+    std::vector<SpriteProjection> visible;
+};
+
+inline BatchScratch& ThreadBatchScratch() {
+    thread_local BatchScratch scratch;
+    return scratch;
+}
+
+class BatchRenderer {
+public:
+    BatchRenderer(int width, int height, float fov = FOV) : width(width), height(height), fov(fov) {
+        BuildColumnTables(columns, width, fov);
+        // Profundidad del piso o techo de cada fila (la misma que usa RenderFloorRows)
+        rowDistance.resize(height);
+        for (int y = 0; y < height; y++) {
+            float rowOffset = y >= height / 2 ? y + 0.5f - height / 2 : height / 2 - y - 0.5f;
+            rowDistance[y] = (height * BLOCK_SIZE / 2) / rowOffset;
+        }
+    }
+
+    int Width() const { return width; }
+    int Height() const { return height; }
+
+    // Renderiza poses[0, count) sobre map y sus sprites (spriteSet puede ser
+    // nullptr). La vista i va en out.rgb + i * width * height * 3 y en
+    // out.depth + i * width * height. Con pool las vistas se reparten entre
+    // sus hilos; sin pool se renderizan en el hilo que llama.
+    void Render(const MapView& map, const SpriteSet* spriteSet, const ViewPose* poses, int count, const BatchFrames& out,
+                ThreadPool* pool = nullptr) const {
+        size_t pixels = (size_t)width * height;
+        if (pool == nullptr) {
+            for (int i = 0; i < count; i++) {
+                RenderView(map, spriteSet, poses[i], out.rgb + i * pixels * 3, out.depth != nullptr ? out.depth + i * pixels : nullptr);
+            }
+            return;
+        }
+        BatchJob job = {&map, spriteSet, poses, &out};
+        pool->ParallelFor(count, [this, &job](int i) {
+            size_t pixels = (size_t)width * height;
+            float* depth = job.out->depth != nullptr ? job.out->depth + i * pixels : nullptr;
+            RenderView(*job.map, job.spriteSet, job.poses[i], job.out->rgb + i * pixels * 3, depth);
+        });
+    }
+
+    // Una vista: width * height pixeles RGB en rgb y, si depth no es nullptr,
+    // la distancia a la camara (sobre la direccion de vista, en unidades de
+    // mundo) de lo que se ve en cada pixel
+    void RenderView(const MapView& map, const SpriteSet* spriteSet, const ViewPose& pose, uint8_t* rgb, float* depth) const {
+        BatchScratch& scratch = ThreadBatchScratch();
+        scratch.pixels.resize((size_t)width * height);
+        scratch.columnDepth.resize(width);
+        RenderTarget target = {scratch.pixels.data(), width, height, scratch.columnDepth.data(), &scratch.pyramid, &columns, depth};
+
+        Player player = {pose.x, pose.y, pose.angle, false};
+        Camera camera = SetupCamera(player, fov);
+        target.pyramid->Attach(target.depth, width);
+        RenderFloorRows(camera, map, target, 0, height);
+        ColumnReuse noReuse = {nullptr, 0.0f, nullptr};
+        for (int startX = 0; startX < width; startX += TILE_WIDTH) {
+            RenderColumns(camera, map, target, startX, std::min(startX + TILE_WIDTH, width), noReuse);
+        }
+        target.pyramid->Finish(TILE_WIDTH);
+
+        // Cada pixel ve la pared de su columna o, si esta mas cerca, el piso
+        // o techo de su fila; los sprites escriben encima su profundidad
+        if (depth != nullptr) {
+            for (int y = 0; y < height; y++) {
+                float* row = depth + (size_t)y * width;
+                for (int x = 0; x < width; x++) row[x] = std::min(target.depth[x], rowDistance[y]);
+            }
+        }
+
+        if (spriteSet != nullptr) {
+            scratch.visible.clear();
+            ForEachSpriteInView(camera, map, *spriteSet, target, [&scratch](int, const SpriteProjection& projection, bool occluded) {
+                if (!occluded) scratch.visible.push_back(projection);
+            });
+            std::sort(scratch.visible.begin(), scratch.visible.end(), [](const SpriteProjection& a, const SpriteProjection& b) {
+                if (a.depth != b.depth) return a.depth > b.depth;
+                return a.screenX < b.screenX;
+            });
+            for (const SpriteProjection& sprite : scratch.visible) {
+                DrawSprite(target, sprite, spriteTextures[sprite.type], 0, width);
+            }
+        }
+
+        const Color* pixel = target.pixels;
+        for (size_t i = 0; i < (size_t)width * height; i++, rgb += 3) {
+            rgb[0] = pixel[i].r;
+            rgb[1] = pixel[i].g;
+            rgb[2] = pixel[i].b;
+        }
+    }
+
+private:
+    struct BatchJob {
+        const MapView* map;
+        const SpriteSet* spriteSet;
+        const ViewPose* poses;
+        const BatchFrames* out;
+    };
+
+    int width, height;
+    float fov;
+    ColumnTables columns;
+    std::vector<float> rowDistance;
+};
@@ -0,0 +1,887 @@
+// Benchmark sin ventana del renderizador.
+//
+// Recorre caminos de camara con guion fijo sobre los niveles del juego y
+// sobre mapas sinteticos grandes, usando el mismo RenderScene que el juego
+// pero sin abrir ventana ni tocar la GPU. Por cada escenario reporta ms por
+// frame (media y percentiles), rayos/s, pixeles/s, sprites dibujados y
+// descartados por oclusion por frame, y un checksum de todos los frames
+// para detectar cambios en la imagen.
+//
+// Mrays/s mide solo la pasada de rayos, en un hilo.
+//
+// Uso: bench [--frames N] [--threads N] [--ray-kernel scalar|sse|avx2]
+//            [--scenario nombre] [--skip on|off|both]
+//            [--baseline archivo] [--write-baseline archivo] [--trace archivo]
+//            [--scale f] [--reuse on|off] [--batch-view WxH]
+//            [--replay archivo [--replay-csv archivo]]
+//
+// Cada escenario corre con y sin salto de espacio vacio (filas "+skip");
+// las dos variantes deben dar el mismo checksum. Antes de la tabla se listan
+// los escenarios en que un nivel con ese mapa tendria el salto activado
+// (ver EmptySpaceWorthSkipping).
+//
+// Con --baseline el programa termina con codigo 1 si algun checksum no
+// coincide con el archivo, para poder usarlo como puerta en CI.
+//
+// --trace escribe las etapas de los ultimos frames en un trace de Chrome
+// (y en archivo.csv); requiere el perfilador (ver profiler.h).
+//
+// --scale renderiza a una resolucion interna fija (0.5 = la mitad de ancho
+// y de alto), como la que elige la resolucion dinamica del juego.
+//
+// Los escenarios "look-" dejan la camara quieta girando; con --reuse off se
+// desactiva el reuso entre frames, que no debe cambiar el checksum.
+//
+// Los escenarios "lit-" tienen iluminacion por celda (ver lighting.h) con
+// una luz dinamica que sigue a la camara; su tiempo incluye recalcular la
+// luz que esa luz mueve.
+//
+// Los escenarios "pvs-" usan el PVS del mapa (ver pvs.h) para descartar
+// sprites; deben dar el mismo checksum que el escenario "props-" sin PVS.
+// Antes de correrlos se compara el PVS con rayos densos desde una muestra
+// de celdas; si alguna ve algo fuera de su PVS el programa termina con
+// codigo 1. Lo mismo despues de abrir una pared: se mide tambien lo que
+// cuesta UpdateCell y el recalculo diferido de las celdas pendientes.
+//
+// Los escenarios "move-" mueven todos sus sprites en cada frame con
+// colision contra las paredes (ver movement.h); el tiempo del frame incluye
+// ese paso y se reporta tambien aparte.
+//
+// Los escenarios "batch-" miden el render por lotes (ver batch_render.h):
+// vistas por segundo de WxH pixeles (--batch-view, por defecto 64x48) para
+// varios tamaños de lote, repartidas entre los hilos.
+//
+// Al final mide la carga de niveles y revisa que OpenLevelFile rechace
+// niveles con sprites o luces fuera de rango; si alguno se abre el programa
+// termina con codigo 1.
+//
+// --replay repite una partida grabada con "--record" en el juego (ver
+// replay.h) en vez de correr los escenarios: un frame por tick, sin limite
+// de fps. --replay-csv escribe por tick los ms del frame y los hashes del
+// estado y del framebuffer, para encontrar frames lentos y comparar dos
+// versiones; termina con codigo 1 si el estado final no es el grabado.
+
+#include "raycaster.h"
+#include "batch_render.h"
+#include "replay.h"
+#include "movement.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+
+// Mapa del escenario: la grilla, sus sprites y donde arranca la camara
+struct BenchMap {
+    std::vector<uint8_t> cells;     // width * height celdas + relleno para el gather
+    std::vector<uint8_t> emptySpace;
+    int width, height;
+    std::vector<Sprite> sprites;
+    float startX, startY;   // Celda de inicio del camino (coordenadas de celda)
+    bool lookAround = false;  // Camara quieta en el inicio que solo gira (ver CameraPose)
+
+    // Iluminacion (ver lighting.h): sin luces y con ambiente LIGHT_FULL el
+    // mapa no tiene; lantern agrega una luz dinamica que sigue a la camara
+    std::vector<PointLight> lights;
+    int ambientLight = LIGHT_FULL;
+    bool lantern = false;
+    LightGrid light;        // Horneada en main junto con el espacio vacio
+
+    // Con pvs, main calcula el PVS del mapa (ver pvs.h) y el render lo usa
+    bool pvs = false;
+    PotentiallyVisibleSet visibility;
+
+    // Con moving todos los sprites se mueven en cada frame (ver movement.h)
+    bool moving = false;
+};
+
+struct BenchResult {
+    std::string name;
+    int frames;
+    double meanMs, p50Ms, p90Ms, p99Ms, maxMs;
+    double raysPerSec, pixelsPerSec;
+    double spritesDrawn, spritesOccluded;  // Promedio por frame
+    uint64_t checksum;
+    int entities = 0;                       // Entidades que se mueven, si hay
+    double entityMeanMs = 0, entityMaxMs = 0;
+};
+
+// Generador congruencial propio para que los mapas no dependan de la libc
+struct BenchRandom {
+    uint32_t state;
+    uint32_t Next() {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+};
+
+BenchMap LevelBenchMap(int level) {
+    Player player;
+    std::string error;
+    if (!LoadLevel(level, player, &error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        exit(2);
+    }
+
+    BenchMap bench;
+    bench.width = mapWidth;
+    bench.height = mapHeight;
+    bench.cells.assign(worldMap, worldMap + LevelCellsBytes(mapWidth, mapHeight));
+    for (int i = 0; i < sprites.Count(); i++) bench.sprites.push_back({sprites.x[i], sprites.y[i], sprites.type[i]});
+    bench.startX = player.x / BLOCK_SIZE;
+    bench.startY = player.y / BLOCK_SIZE;
+    bench.ambientLight = (int)worldLevel.ambientLight;
+    for (uint32_t i = 0; i < worldLevel.lightCount; i++) {
+        const LevelLight& light = worldLevel.lights[i];
+        bench.lights.push_back({light.x, light.y, light.radius, light.intensity});
+    }
+    return bench;
+}
+
+// Sprites en una de cada "spacing" celdas vacias
+void ScatterSprites(BenchMap& bench, int spacing, BenchRandom& random) {
+    for (int y = 0; y < bench.height; y++) {
+        for (int x = 0; x < bench.width; x++) {
+            if (bench.cells[y * bench.width + x] == 0 && random.Next() % spacing == 0) {
+                bench.sprites.push_back({BLOCK_SIZE * (x + 0.5f), BLOCK_SIZE * (y + 0.5f), (int)(random.Next() % 3)});
+            }
+        }
+    }
+}
+
+// Mapa abierto de size x size con borde y una columna suelta de cada
+// "pillarChance" celdas, y un sprite de cada "spriteSpacing" celdas vacias
+BenchMap OpenBenchMap(int size, int pillarChance = 50, int spriteSpacing = 40) {
+    BenchRandom random = {12345u};
+    BenchMap bench;
+    bench.width = size;
+    bench.height = size;
+    bench.cells.assign(LevelCellsBytes(size, size), 0);
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            bool border = x == 0 || y == 0 || x == size - 1 || y == size - 1;
+            if (border) {
+                bench.cells[y * size + x] = 1;
+            } else if (random.Next() % pillarChance == 0) {
+                bench.cells[y * size + x] = 2 + random.Next() % 2;
+            }
+        }
+    }
+    bench.startX = size / 2 + 0.5f;
+    bench.startY = size / 2 + 0.5f;
+    bench.cells[(size / 2) * size + size / 2] = 0;
+    ScatterSprites(bench, spriteSpacing, random);
+    return bench;
+}
+
+// Laberinto de size x size (size impar) generado con backtracking, con un
+// sprite de cada "spriteSpacing" celdas vacias
+BenchMap MazeBenchMap(int size, int spriteSpacing = 12) {
+    BenchRandom random = {6789u};
+    BenchMap bench;
+    bench.width = size;
+    bench.height = size;
+    bench.cells.assign(LevelCellsBytes(size, size), 0);
+    std::fill(bench.cells.begin(), bench.cells.begin() + size * size, 1);
+
+    std::vector<int> stack = {1 * size + 1};
+    bench.cells[1 * size + 1] = 0;
+    const int dx[4] = {2, -2, 0, 0};
+    const int dy[4] = {0, 0, 2, -2};
+    while (!stack.empty()) {
+        int cx = stack.back() % size;
+        int cy = stack.back() / size;
+        int options[4];
+        int count = 0;
+        for (int d = 0; d < 4; d++) {
+            int nx = cx + dx[d];
+            int ny = cy + dy[d];
+            if (nx > 0 && ny > 0 && nx < size - 1 && ny < size - 1 && bench.cells[ny * size + nx] != 0) {
+                options[count++] = d;
+            }
+        }
+        if (count == 0) {
+            stack.pop_back();
+            continue;
+        }
+        int d = options[random.Next() % count];
+        bench.cells[(cy + dy[d] / 2) * size + cx + dx[d] / 2] = 0;
+        bench.cells[(cy + dy[d]) * size + cx + dx[d]] = 0;
+        stack.push_back((cy + dy[d]) * size + cx + dx[d]);
+    }
+
+    // Variar el tipo de pared para que el checksum cubra todos los colores
+    for (int i = 0; i < size * size; i++) {
+        if (bench.cells[i] != 0) bench.cells[i] = 1 + random.Next() % 3;
+    }
+    bench.startX = 1.5f;
+    bench.startY = 1.5f;
+    ScatterSprites(bench, spriteSpacing, random);
+    return bench;
+}
+
+BenchMap Moving(BenchMap bench) {
+    bench.moving = true;
+    return bench;
+}
+
+// Una entidad por sprite con direccion y rapidez (0.02 a 0.1 celdas por
+// tick) al azar pero fijas
+void AddMovingEntities(const BenchMap& bench, MovingEntities& entities) {
+    BenchRandom random = {424242u};
+    entities.Clear();
+    for (int i = 0; i < (int)bench.sprites.size(); i++) {
+        float angle = (random.Next() % 3600) * (2 * PI / 3600);
+        float speed = 0.02f + (random.Next() % 1000) * 0.00008f;
+        entities.Add(bench.sprites[i].x / BLOCK_SIZE, bench.sprites[i].y / BLOCK_SIZE, cosf(angle) * speed, sinf(angle) * speed, i);
+    }
+}
+
+BenchMap WithPvs(BenchMap bench) {
+    bench.pvs = true;
+    return bench;
+}
+
+BenchMap LookAround(BenchMap bench) {
+    bench.lookAround = true;
+    return bench;
+}
+
+// Luz ambiente baja, una luz fija cada "spacing" celdas (en las vacias) y
+// la linterna de la camara, que se mueve en cada frame
+BenchMap LitBenchMap(BenchMap bench, int spacing) {
+    bench.ambientLight = 80;
+    for (int y = spacing / 2; y < bench.height; y += spacing) {
+        for (int x = spacing / 2; x < bench.width; x += spacing) {
+            if (bench.cells[y * bench.width + x] == 0) bench.lights.push_back({x + 0.5f, y + 0.5f, spacing * 0.6f, 150});
+        }
+    }
+    bench.lantern = true;
+    return bench;
+}
+
+// Camino de la camara: recorrido en profundidad de las celdas vacias desde
+// la celda inicial, volviendo por el mismo camino al terminar cada rama.
+// Asi pasa solo por celdas vacias en cualquier mapa.
+std::vector<int> CameraTour(const BenchMap& bench, int maxCells) {
+    std::vector<int> tour;
+    std::vector<bool> visited((size_t)bench.width * bench.height, false);
+    std::vector<int> stack = {(int)bench.startY * bench.width + (int)bench.startX};
+    visited[stack[0]] = true;
+    tour.push_back(stack[0]);
+
+    const int dx[4] = {1, 0, -1, 0};
+    const int dy[4] = {0, 1, 0, -1};
+    while (!stack.empty() && (int)tour.size() < maxCells) {
+        int cx = stack.back() % bench.width;
+        int cy = stack.back() / bench.width;
+        bool advanced = false;
+        for (int d = 0; d < 4 && !advanced; d++) {
+            int nx = cx + dx[d];
+            int ny = cy + dy[d];
+            int index = ny * bench.width + nx;
+            if (nx >= 0 && ny >= 0 && nx < bench.width && ny < bench.height && !visited[index] && bench.cells[index] == 0) {
+                visited[index] = true;
+                stack.push_back(index);
+                tour.push_back(index);
+                advanced = true;
+            }
+        }
+        if (!advanced) {
+            stack.pop_back();
+            if (!stack.empty()) tour.push_back(stack.back());
+        }
+    }
+    return tour;
+}
+
+// Pose de la camara en el frame "frame": avanza una celda del recorrido cada
+// FRAMES_PER_CELL frames mirando hacia donde camina, con un barrido lateral
+const int FRAMES_PER_CELL = 8;
+
+Player CameraPose(const BenchMap& bench, const std::vector<int>& tour, int frame) {
+    // Mirar alrededor sin moverse: gira 3 de cada 4 frames a la velocidad
+    // del juego y el cuarto repite la pose (prueba el reuso entre frames)
+    if (bench.lookAround) {
+        return {BLOCK_SIZE * bench.startX, BLOCK_SIZE * bench.startY, 0.05f * (frame - frame / 4), false};
+    }
+
+    int segments = (int)tour.size() - 1;
+    int segment = (frame / FRAMES_PER_CELL) % (segments > 0 ? segments : 1);
+    float f = (float)(frame % FRAMES_PER_CELL) / FRAMES_PER_CELL;
+
+    int from = tour[segment];
+    int to = segments > 0 ? tour[segment + 1] : from;
+    float fromX = from % bench.width + 0.5f, fromY = from / bench.width + 0.5f;
+    float toX = to % bench.width + 0.5f, toY = to / bench.width + 0.5f;
+
+    Player pose;
+    pose.x = BLOCK_SIZE * (fromX + (toX - fromX) * f);
+    pose.y = BLOCK_SIZE * (fromY + (toY - fromY) * f);
+    pose.angle = atan2f(toY - fromY, toX - fromX) + 0.6f * sinf(frame * 0.05f);
+    pose.hasWon = false;
+    return pose;
+}
+
+uint64_t HashFrame(uint64_t hash) {
+    // FNV-1a sobre el framebuffer y el buffer de profundidad (la parte en uso)
+    const unsigned char* bytes = (const unsigned char*)frameBuffer;
+    for (size_t i = 0; i < sizeof(Color) * renderWidth * renderHeight; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    bytes = (const unsigned char*)depthBuffer;
+    for (size_t i = 0; i < sizeof(float) * renderWidth; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+double Percentile(std::vector<double> sorted, double p) {
+    size_t index = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+// Rayos por segundo de la pasada de paredes sola (sin pintar ni sprites),
+// en un solo hilo, sobre las mismas poses de camara
+double MeasureRaysPerSec(const BenchMap& bench, const MapView& map, const std::vector<int>& tour, int frames) {
+    std::vector<float> dirX(renderWidth), dirY(renderWidth);
+    std::vector<float> distance(renderWidth), wallHeight(renderWidth), wallX(renderWidth);
+    std::vector<int> brightness(renderWidth), cell(renderWidth), side(renderWidth);
+    WallHits hits = {distance.data(), wallHeight.data(), brightness.data(), cell.data(), side.data(), wallX.data()};
+
+    UpdateColumnTables(renderWidth, FOV);
+    double totalMs = 0;
+    for (int frame = 0; frame < frames; frame++) {
+        Camera camera = SetupCamera(CameraPose(bench, tour, frame), FOV);
+        CameraRays(camera, 0, renderWidth, dirX.data(), dirY.data());
+        RayBatch batch = {camera.x, camera.y, dirX.data(), dirY.data(), columnTables.invLength.data(), renderWidth};
+
+        auto start = std::chrono::steady_clock::now();
+        CastRays(map, batch, BLOCK_SIZE, renderHeight, hits, rayKernel);
+        auto end = std::chrono::steady_clock::now();
+        totalMs += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    return (double)renderWidth * frames / (totalMs / 1000.0);
+}
+
+// Compara el PVS con la visibilidad por fuerza bruta: desde puntos al azar
+// de una muestra de hasta maxCells celdas vacias, rayos densos que recorren
+// la grilla hasta la primera pared; toda celda que cruzan tiene que estar en
+// el PVS de la celda de partida. Devuelve cuantas celdas de la muestra ven
+// algo fuera de su PVS.
+int CheckPvs(const BenchMap& bench, int maxCells, int& checkedCells) {
+    const int points = 16, rays = 512;
+    BenchRandom random = {97531u};
+    auto unit = [&random] { return 0.001f + (random.Next() % 9980) * 0.0001f; };
+    int emptyCells = 0;
+    for (int i = 0; i < bench.width * bench.height; i++) emptyCells += bench.cells[i] == 0;
+    int stride = std::max(1, emptyCells / maxCells);
+
+    int failed = 0, seen = 0;
+    checkedCells = 0;
+    for (int y = 0; y < bench.height; y++) {
+        for (int x = 0; x < bench.width; x++) {
+            if (bench.cells[y * bench.width + x] != 0 || seen++ % stride != 0) continue;
+            checkedCells++;
+            const PvsCell* visible = bench.visibility.Lookup(x, y);
+            bool missing = visible == nullptr;
+            for (int p = 0; p < points && !missing; p++) {
+                float posX = x + unit(), posY = y + unit();
+                for (int k = 0; k < rays && !missing; k++) {
+                    float angle = (k + unit()) * (2 * PI / rays);
+                    float dirX = cosf(angle), dirY = sinf(angle);
+                    int mapX = x, mapY = y;
+                    float deltaX = dirX == 0.0f ? 1e30f : fabsf(1.0f / dirX);
+                    float deltaY = dirY == 0.0f ? 1e30f : fabsf(1.0f / dirY);
+                    int stepX = dirX < 0 ? -1 : 1, stepY = dirY < 0 ? -1 : 1;
+                    float sideX = (dirX < 0 ? posX - mapX : mapX + 1.0f - posX) * deltaX;
+                    float sideY = (dirY < 0 ? posY - mapY : mapY + 1.0f - posY) * deltaY;
+                    while (mapX >= 0 && mapY >= 0 && mapX < bench.width && mapY < bench.height) {
+                        if (!visible->Contains(mapX, mapY)) {
+                            missing = true;
+                            break;
+                        }
+                        if (bench.cells[mapY * bench.width + mapX] != 0) break;
+                        if (sideX < sideY) {
+                            sideX += deltaX;
+                            mapX += stepX;
+                        } else {
+                            sideY += deltaY;
+                            mapY += stepY;
+                        }
+                    }
+                }
+            }
+            if (missing) failed++;
+        }
+    }
+    return failed;
+}
+
+// Abre la pared interior mas cercana al centro del mapa, mide UpdateCell
+// (lo que paga el hilo principal del juego) y el recalculo diferido de las
+// celdas que quedan pendientes, y compara el resultado como CheckPvs. Deja
+// el mapa y el PVS como estaban.
+int CheckPvsUpdate(BenchMap& bench, double& updateMs, double& recomputeMs, int& checkedCells) {
+    int wall = -1, best = 0;
+    for (int y = 1; y + 1 < bench.height; y++) {
+        for (int x = 1; x + 1 < bench.width; x++) {
+            int i = y * bench.width + x;
+            bool besideEmpty = bench.cells[i - 1] == 0 || bench.cells[i + 1] == 0 || bench.cells[i - bench.width] == 0 ||
+                               bench.cells[i + bench.width] == 0;
+            int distance = abs(2 * x - bench.width) + abs(2 * y - bench.height);
+            if (bench.cells[i] != 0 && besideEmpty && (wall < 0 || distance < best)) {
+                wall = i;
+                best = distance;
+            }
+        }
+    }
+    checkedCells = 0;
+    if (wall < 0) return 0;
+
+    MapView map = {bench.cells.data(), bench.width, bench.height};
+    uint8_t value = bench.cells[wall];
+    bench.cells[wall] = 0;
+    auto start = std::chrono::steady_clock::now();
+    bench.visibility.UpdateCell(map, wall % bench.width, wall / bench.width);
+    auto middle = std::chrono::steady_clock::now();
+    bench.visibility.RecomputePending(map);
+    auto end = std::chrono::steady_clock::now();
+    updateMs = std::chrono::duration<double, std::milli>(middle - start).count();
+    recomputeMs = std::chrono::duration<double, std::milli>(end - middle).count();
+    int failed = CheckPvs(bench, 400, checkedCells);
+
+    bench.cells[wall] = value;
+    bench.visibility.Build(map);
+    return failed;
+}
+
+BenchResult RunScenario(const std::string& name, const BenchMap& bench, int frames, bool skip) {
+    // Copia de la luz horneada, para que la linterna no la cambie entre corridas
+    LightGrid light = bench.light;
+    MapView map = {bench.cells.data(), bench.width, bench.height, skip ? bench.emptySpace.data() : nullptr, light.Data(),
+                   bench.visibility.IsLoaded() ? &bench.visibility : nullptr};
+    std::vector<int> tour = CameraTour(bench, frames / FRAMES_PER_CELL + 2);
+    int lantern = bench.lantern && light.IsLit() ? light.AddLight(map, {bench.startX, bench.startY, 6.0f, 120}) : -1;
+
+    // Unos frames de calentamiento para caches y los hilos del pool
+    SetSprites(bench.sprites, bench.width, bench.height);
+    for (int frame = 0; frame < 5; frame++) {
+        RenderScene(CameraPose(bench, tour, frame), map);
+    }
+
+    SetSprites(bench.sprites, bench.width, bench.height);
+    MovingEntities entities;
+    if (bench.moving) AddMovingEntities(bench, entities);
+    std::vector<double> times, entityTimes;
+    uint64_t checksum = 1469598103934665603ull;
+    double totalMs = 0;
+    long long spritesDrawn = 0, spritesOccluded = 0;
+    for (int frame = 0; frame < frames; frame++) {
+        Player pose = CameraPose(bench, tour, frame);
+        PROFILE_FRAME();
+        auto start = std::chrono::steady_clock::now();
+        if (lantern >= 0) {
+            light.MoveLight(map, lantern, pose.x / BLOCK_SIZE, pose.y / BLOCK_SIZE);
+            sceneVersion++;
+        }
+        if (bench.moving) {
+            entities.Step(map, renderPool);
+            entities.ApplyTo(sprites, BLOCK_SIZE);
+            spriteVersion++;
+            entityTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        RenderScene(pose, map);
+        auto end = std::chrono::steady_clock::now();
+        spritesDrawn += spriteStats.drawn;
+        spritesOccluded += spriteStats.occluded;
+
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        times.push_back(ms);
+        totalMs += ms;
+        checksum = HashFrame(checksum);
+    }
+
+    std::sort(times.begin(), times.end());
+    BenchResult result;
+    result.name = name;
+    result.frames = frames;
+    result.meanMs = totalMs / frames;
+    result.p50Ms = Percentile(times, 0.50);
+    result.p90Ms = Percentile(times, 0.90);
+    result.p99Ms = Percentile(times, 0.99);
+    result.maxMs = times.back();
+    result.raysPerSec = MeasureRaysPerSec(bench, map, tour, frames);
+    result.pixelsPerSec = (double)renderWidth * renderHeight * frames / (totalMs / 1000.0);
+    result.spritesDrawn = (double)spritesDrawn / frames;
+    result.spritesOccluded = (double)spritesOccluded / frames;
+    result.checksum = checksum;
+    if (bench.moving) {
+        result.entities = entities.Count();
+        for (double ms : entityTimes) result.entityMeanMs += ms / frames;
+        result.entityMaxMs = *std::max_element(entityTimes.begin(), entityTimes.end());
+    }
+    return result;
+}
+
+struct BatchResult {
+    int batchSize;
+    double msPerBatch;
+    double viewsPerSec;
+    uint64_t checksum;
+};
+
+// Render por lotes de las poses del camino de camara: lotes de batchSize
+// vistas hasta juntar al menos BATCH_VIEWS vistas por tamaño. El checksum
+// cubre el RGB y la profundidad del primer lote.
+const int BATCH_VIEWS = 4096;
+
+BatchResult RunBatch(const BenchMap& bench, const BatchRenderer& renderer, int batchSize) {
+    MapView map = {bench.cells.data(), bench.width, bench.height, bench.emptySpace.data(), bench.light.Data(),
+                   bench.visibility.IsLoaded() ? &bench.visibility : nullptr};
+    std::vector<int> tour = CameraTour(bench, batchSize / FRAMES_PER_CELL + 2);
+    std::vector<ViewPose> poses;
+    for (int i = 0; i < batchSize; i++) {
+        Player pose = CameraPose(bench, tour, i);
+        poses.push_back({pose.x, pose.y, pose.angle});
+    }
+    size_t pixels = (size_t)renderer.Width() * renderer.Height();
+    std::vector<uint8_t> rgb(pixels * 3 * batchSize);
+    std::vector<float> depth(pixels * batchSize);
+    BatchFrames out = {rgb.data(), depth.data()};
+
+    // Un lote de calentamiento: reserva la memoria de trabajo de cada hilo
+    renderer.Render(map, &sprites, poses.data(), batchSize, out, renderPool);
+    uint64_t checksum = 1469598103934665603ull;
+    for (uint8_t byte : rgb) checksum = (checksum ^ byte) * 1099511628211ull;
+    const unsigned char* bytes = (const unsigned char*)depth.data();
+    for (size_t i = 0; i < depth.size() * sizeof(float); i++) checksum = (checksum ^ bytes[i]) * 1099511628211ull;
+
+    int rounds = std::max(1, BATCH_VIEWS / batchSize);
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        renderer.Render(map, &sprites, poses.data(), batchSize, out, renderPool);
+    }
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    BatchResult result;
+    result.batchSize = batchSize;
+    result.msPerBatch = totalMs / rounds;
+    result.viewsPerSec = (double)batchSize * rounds / (totalMs / 1000.0);
+    result.checksum = checksum;
+    return result;
+}
+
+// Repite la grabacion path con la simulacion y el render del juego
+int RunReplay(const char* path, const char* csvPath) {
+    ReplayLog log;
+    Player player;
+    std::string error;
+    if (!ReadReplay(path, log, &error) || !LoadReplayLevel(log, player, &error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+    FILE* csv = csvPath != NULL ? fopen(csvPath, "w") : NULL;
+    if (csv != NULL) fprintf(csv, "tick,ms,state_hash,frame_hash\n");
+
+    Simulation simulation;
+    simulation.Reset(player);
+    std::vector<double> times;
+    uint64_t checksum = 1469598103934665603ull;
+    Player state = player;
+    for (size_t tick = 0; tick < log.inputs.size(); tick++) {
+        // Un tick exacto por frame, como en el juego pero sin esperar a nadie
+        simulation.Start(UnpackInput(log.inputs[tick]), SIM_TICK_SECONDS);
+        const SimSnapshot& snapshot = simulation.Wait();
+        for (const CellEdit& edit : snapshot.edits) SetMapCell(edit.x, edit.y, edit.value);
+        state = snapshot.current;
+
+        PROFILE_FRAME();
+        auto start = std::chrono::steady_clock::now();
+        RenderScene(state, CurrentMapView());
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        times.push_back(ms);
+        uint64_t frameHash = HashFrame(1469598103934665603ull);
+        checksum = HashFrame(checksum);
+        if (csv != NULL) {
+            fprintf(csv, "%zu,%.4f,%016llx,%016llx\n", tick, ms, (unsigned long long)HashPlayerState(state), (unsigned long long)frameHash);
+        }
+    }
+    if (csv != NULL) fclose(csv);
+
+    bool sameState = HashPlayerState(state) == log.header.finalStateHash;
+    printf("replay %s: nivel %d, %zu ticks\n", path, log.header.level, log.inputs.size());
+    if (!times.empty()) {
+        double total = 0;
+        for (double ms : times) total += ms;
+        std::vector<double> sorted = times;
+        std::sort(sorted.begin(), sorted.end());
+        size_t slowest = std::max_element(times.begin(), times.end()) - times.begin();
+        printf("  mean %.3f ms, p50 %.3f, p99 %.3f, max %.3f (tick %zu)\n", total / times.size(), Percentile(sorted, 0.50),
+               Percentile(sorted, 0.99), sorted.back(), slowest);
+    }
+    printf("  checksum %016llx, estado final %s\n", (unsigned long long)checksum, sameState ? "igual al grabado" : "DISTINTO al grabado");
+    return sameState ? 0 : 1;
+}
+
+// Tiempo de abrir un archivo de nivel y dejarlo como mapa actual
+double MeasureLevelLoad(const char* path) {
+    Player player;
+    auto start = std::chrono::steady_clock::now();
+    std::string error;
+    bool ok = LoadLevelFile(path, player, &error);
+    auto end = std::chrono::steady_clock::now();
+    if (!ok) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return -1;
+    }
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Escribe un mapa sintetico como archivo de nivel (para medir la carga)
+bool WriteBenchLevel(const char* path, const BenchMap& bench) {
+    std::vector<LevelSprite> levelSprites;
+    for (const auto& sprite : bench.sprites) {
+        levelSprites.push_back({sprite.x / BLOCK_SIZE, sprite.y / BLOCK_SIZE, sprite.type});
+    }
+    return WriteLevelFile(path, bench.width, bench.height, bench.cells.data(), levelSprites.data(),
+                          (uint32_t)levelSprites.size(), bench.startX, bench.startY, 0.0f);
+}
+
+// Escribe niveles de 8x8 con un sprite o una luz fuera de rango y cuenta
+// cuantos abre OpenLevelFile; todos deberian rechazarse. Devuelve -1 si
+// tampoco se abre el mismo nivel con el sprite y la luz validos.
+int CheckInvalidLevels(int& checkedLevels) {
+    const char* path = "bench_invalid.lvl";
+    std::vector<uint8_t> cells(64, 0);
+    LevelSprite goodSprite = {4.5f, 4.5f, 0};
+    LevelLight goodLight = {4.5f, 4.5f, 3.0f, 120};
+    std::vector<LevelSprite> badSprites = {{4.5f, 4.5f, LEVEL_SPRITE_TYPES}, {4.5f, 4.5f, -1}, {NAN, 4.5f, 0}, {4.5f, 8.0f, 0}};
+    std::vector<LevelLight> badLights = {{1e30f, 4.5f, 3.0f, 120}, {4.5f, -0.5f, 3.0f, 120}, {4.5f, 4.5f, 1e9f, 120},
+                                         {4.5f, 4.5f, INFINITY, 120}, {4.5f, 4.5f, 0.0f, 120}, {4.5f, 4.5f, 3.0f, 256}};
+    auto opens = [&](const LevelSprite& sprite, const LevelLight& light) {
+        LevelFile level;
+        return WriteLevelFile(path, 8, 8, cells.data(), &sprite, 1, 1.5f, 1.5f, 0.0f, &light, 1, 110) &&
+               OpenLevelFile(path, level, nullptr);
+    };
+    int accepted = opens(goodSprite, goodLight) ? 0 : -1;
+    for (const LevelSprite& sprite : badSprites) {
+        if (accepted >= 0 && opens(sprite, goodLight)) accepted++;
+    }
+    for (const LevelLight& light : badLights) {
+        if (accepted >= 0 && opens(goodSprite, light)) accepted++;
+    }
+    remove(path);
+    checkedLevels = (int)(badSprites.size() + badLights.size());
+    return accepted;
+}
+
+std::map<std::string, uint64_t> ReadBaseline(const char* path) {
+    std::map<std::string, uint64_t> baseline;
+    FILE* file = fopen(path, "r");
+    if (file == NULL) return baseline;
+    char name[128];
+    unsigned long long checksum;
+    while (fscanf(file, "%127s %llx", name, &checksum) == 2) {
+        baseline[name] = checksum;
+    }
+    fclose(file);
+    return baseline;
+}
+
+int main(int argc, char** argv) {
+    int frames = 600;
+    const char* only = NULL;
+    const char* baselinePath = NULL;
+    const char* writeBaselinePath = NULL;
+    const char* skipModes = "both";
+    const char* tracePath = NULL;
+    float scale = 1.0f;
+    const char* reuseMode = "on";
+    int batchWidth = 64, batchHeight = 48;
+    const char* replayPath = NULL;
+    const char* replayCsvPath = NULL;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--frames") == 0) frames = atoi(argv[i + 1]);
+        if (strcmp(argv[i], "--scenario") == 0) only = argv[i + 1];
+        if (strcmp(argv[i], "--baseline") == 0) baselinePath = argv[i + 1];
+        if (strcmp(argv[i], "--write-baseline") == 0) writeBaselinePath = argv[i + 1];
+        if (strcmp(argv[i], "--skip") == 0) skipModes = argv[i + 1];
+        if (strcmp(argv[i], "--trace") == 0) tracePath = argv[i + 1];
+        if (strcmp(argv[i], "--scale") == 0) scale = (float)atof(argv[i + 1]);
+        if (strcmp(argv[i], "--reuse") == 0) reuseMode = argv[i + 1];
+        if (strcmp(argv[i], "--batch-view") == 0) sscanf(argv[i + 1], "%dx%d", &batchWidth, &batchHeight);
+        if (strcmp(argv[i], "--replay") == 0) replayPath = argv[i + 1];
+        if (strcmp(argv[i], "--replay-csv") == 0) replayCsvPath = argv[i + 1];
+    }
+    batchWidth = std::max(batchWidth, 1);
+    batchHeight = std::max(batchHeight, 2);
+    if (frames < 1) frames = 1;
+
+    renderPool = new ThreadPool(ParseThreadCount(argc, argv));
+    rayKernel = ParseRayKernel(argc, argv);
+    depthBuffer = new float[SCREEN_WIDTH];
+    frameBuffer = new Color[SCREEN_WIDTH * SCREEN_HEIGHT];
+    SetRenderResolution(scale);
+    temporalReuse = strcmp(reuseMode, "off") != 0;
+    CreateSpriteTextures();
+    CreateWallTextures();
+
+    if (replayPath != NULL) {
+        int status = RunReplay(replayPath, replayCsvPath);
+        delete renderPool;
+        delete[] depthBuffer;
+        delete[] frameBuffer;
+        return status;
+    }
+
+    std::vector<std::pair<std::string, BenchMap>> scenarios;
+    scenarios.push_back({"level1", LevelBenchMap(1)});
+    scenarios.push_back({"level2", LevelBenchMap(2)});
+    scenarios.push_back({"open256", OpenBenchMap(256)});
+    scenarios.push_back({"maze255", MazeBenchMap(255)});
+    scenarios.push_back({"open1024", OpenBenchMap(1024)});
+    scenarios.push_back({"sparse2048", OpenBenchMap(2048, 4000, 4000)});
+    scenarios.push_back({"props1024", OpenBenchMap(1024, 50, 4)});
+    scenarios.push_back({"look-level1", LookAround(LevelBenchMap(1))});
+    scenarios.push_back({"look-open1024", LookAround(OpenBenchMap(1024))});
+    scenarios.push_back({"lit-open1024", LitBenchMap(OpenBenchMap(1024), 12)});
+    scenarios.push_back({"props-maze255", MazeBenchMap(255, 2)});
+    scenarios.push_back({"pvs-maze255", WithPvs(MazeBenchMap(255, 2))});
+    scenarios.push_back({"props-pillars96", OpenBenchMap(96, 5, 2)});
+    scenarios.push_back({"pvs-pillars96", WithPvs(OpenBenchMap(96, 5, 2))});
+    scenarios.push_back({"move-open1024", Moving(OpenBenchMap(1024, 50, 100))});
+    scenarios.push_back({"move-maze255", Moving(MazeBenchMap(255, 3))});
+    int mismatches = 0;
+    std::string skipWorthIt;
+    for (auto& scenario : scenarios) {
+        BenchMap& bench = scenario.second;
+        bench.emptySpace.assign(bench.cells.size(), 0);
+        BuildEmptySpaceField(bench.cells.data(), bench.width, bench.height, bench.emptySpace.data());
+        if (EmptySpaceWorthSkipping(bench.cells.data(), bench.emptySpace.data(), bench.width, bench.height)) {
+            skipWorthIt += " " + scenario.first;
+        }
+        if (!bench.lights.empty() || bench.ambientLight < LIGHT_FULL) {
+            bench.light.Bake({bench.cells.data(), bench.width, bench.height, bench.emptySpace.data()}, bench.ambientLight, bench.lights);
+        }
+        if (bench.pvs && (only == NULL || scenario.first == only)) {
+            auto start = std::chrono::steady_clock::now();
+            bench.visibility.Build({bench.cells.data(), bench.width, bench.height, bench.emptySpace.data()});
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            int checked;
+            int failed = CheckPvs(bench, 400, checked);
+            printf("pvs %s: %.1f ms, %zu bytes, %d de %d celdas ven algo fuera del PVS\n", scenario.first.c_str(), ms,
+                   bench.visibility.EncodedBytes(), failed, checked);
+            if (failed > 0) mismatches++;
+
+            double updateMs = 0, recomputeMs = 0;
+            failed = CheckPvsUpdate(bench, updateMs, recomputeMs, checked);
+            printf("pvs %s: abrir una pared %.3f ms, recalculo diferido %.1f ms, %d de %d celdas ven algo fuera del PVS\n",
+                   scenario.first.c_str(), updateMs, recomputeMs, failed, checked);
+            if (failed > 0) mismatches++;
+        }
+    }
+
+    printf("salto de espacio vacio activado por el nivel en:%s\n", skipWorthIt.empty() ? " ninguno" : skipWorthIt.c_str());
+
+    std::vector<bool> skips;
+    if (strcmp(skipModes, "on") != 0) skips.push_back(false);
+    if (strcmp(skipModes, "off") != 0) skips.push_back(true);
+
+    printf("threads=%d kernel=%s resolution=%dx%d frames=%d\n", renderPool->ThreadCount(),
+           RayKernelName(rayKernel == RAY_KERNEL_AUTO ? DetectRayKernel() : rayKernel), renderWidth, renderHeight, frames);
+    printf("%-14s %8s %8s %8s %8s %8s %12s %12s %9s %9s  %s\n", "scenario", "mean_ms", "p50_ms", "p90_ms", "p99_ms", "max_ms", "Mrays/s", "Mpixels/s",
+           "spr_draw", "spr_occl", "checksum");
+
+    std::map<std::string, uint64_t> baseline;
+    if (baselinePath != NULL) baseline = ReadBaseline(baselinePath);
+    FILE* writeBaseline = writeBaselinePath != NULL ? fopen(writeBaselinePath, "w") : NULL;
+
+    for (const auto& scenario : scenarios) {
+        if (only != NULL && scenario.first != only) continue;
+        for (bool skip : skips) {
+            BenchResult r = RunScenario(skip ? scenario.first + "+skip" : scenario.first, scenario.second, frames, skip);
+            printf("%-14s %8.3f %8.3f %8.3f %8.3f %8.3f %12.2f %12.2f %9.1f %9.1f  %016llx\n", r.name.c_str(), r.meanMs, r.p50Ms, r.p90Ms, r.p99Ms, r.maxMs,
+                   r.raysPerSec / 1e6, r.pixelsPerSec / 1e6, r.spritesDrawn, r.spritesOccluded, (unsigned long long)r.checksum);
+            if (r.entities > 0) printf("  %d entidades: %.3f ms por tick (max %.3f)\n", r.entities, r.entityMeanMs, r.entityMaxMs);
+
+            if (writeBaseline != NULL) {
+                fprintf(writeBaseline, "%s %016llx\n", r.name.c_str(), (unsigned long long)r.checksum);
+            }
+            auto expected = baseline.find(r.name);
+            if (baselinePath != NULL && (expected == baseline.end() || expected->second != r.checksum)) {
+                printf("  checksum distinto al de %s\n", baselinePath);
+                mismatches++;
+            }
+        }
+    }
+
+    // Render por lotes: vistas por segundo segun el tamaño del lote
+    std::vector<std::pair<std::string, const BenchMap*>> batchScenarios = {{"batch-level1", &scenarios[0].second},
+                                                                            {"batch-open1024", &scenarios[4].second}};
+    BatchRenderer batchRenderer(batchWidth, batchHeight);
+    bool batchHeader = false;
+    for (const auto& scenario : batchScenarios) {
+        if (only != NULL && scenario.first != only) continue;
+        if (!batchHeader) {
+            printf("batch view=%dx%d\n%-14s %6s %10s %12s  %s\n", batchWidth, batchHeight, "scenario", "batch", "ms/batch", "views/s", "checksum");
+            batchHeader = true;
+        }
+        const BenchMap& bench = *scenario.second;
+        SetSprites(bench.sprites, bench.width, bench.height);
+        for (int batchSize : {1, 16, 256, 1024}) {
+            BatchResult r = RunBatch(bench, batchRenderer, batchSize);
+            std::string name = scenario.first + "/" + std::to_string(batchSize);
+            printf("%-14s %6d %10.3f %12.0f  %016llx\n", scenario.first.c_str(), r.batchSize, r.msPerBatch, r.viewsPerSec,
+                   (unsigned long long)r.checksum);
+
+            if (writeBaseline != NULL) {
+                fprintf(writeBaseline, "%s %016llx\n", name.c_str(), (unsigned long long)r.checksum);
+            }
+            auto expected = baseline.find(name);
+            if (baselinePath != NULL && (expected == baseline.end() || expected->second != r.checksum)) {
+                printf("  checksum distinto al de %s\n", baselinePath);
+                mismatches++;
+            }
+        }
+    }
+    if (writeBaseline != NULL) fclose(writeBaseline);
+
+    if (tracePath != NULL) {
+#ifdef RAYCASTER_PROFILING
+        std::string csvPath = std::string(tracePath) + ".csv";
+        if (!ProfileWriteChromeTrace(tracePath) || !ProfileWriteCsv(csvPath.c_str())) {
+            fprintf(stderr, "no se pudo escribir %s\n", tracePath);
+        }
+#else
+        fprintf(stderr, "--trace necesita compilar sin NDEBUG o con -DRAYCASTER_PROFILE\n");
+#endif
+    }
+
+    // Carga de niveles: abrir el archivo no deberia depender del tamaño del
+    // mapa, y los niveles invalidos no deben abrirse
+    if (only == NULL) {
+        const char* bigPath = "bench_open4096.lvl";
+        BenchMap big = OpenBenchMap(4096);
+        big.sprites.clear();
+        if (WriteBenchLevel(bigPath, big)) {
+            printf("level load: %s %.3f ms, %s %.3f ms (4096x4096)\n", LevelPath(1).c_str(), MeasureLevelLoad(LevelPath(1).c_str()),
+                   bigPath, MeasureLevelLoad(bigPath));
+            worldLevel = LevelFile();
+            remove(bigPath);
+        }
+        int checkedLevels;
+        int accepted = CheckInvalidLevels(checkedLevels);
+        if (accepted < 0) {
+            printf("niveles invalidos: no se pudo abrir el nivel valido de control\n");
+        } else {
+            printf("niveles invalidos: %d de %d se abrieron\n", accepted, checkedLevels);
+        }
+        if (accepted != 0) mismatches++;
+    }
+
+    delete renderPool;
+    delete[] depthBuffer;
+    delete[] frameBuffer;
+    return mismatches > 0 ? 1 : 0;
+}
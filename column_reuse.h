@@ -0,0 +1,96 @@
+#pragma once
+
+// Reutilizacion de rayos entre frames cuando la camara solo gira.
+//
+// Desde la misma posicion, la pared que ve un rayo depende solo de su
+// direccion. Si dos columnas vecinas del frame anterior golpearon la misma
+// cara de la misma celda y entre sus rayos no cabe una celda entera, todo
+// rayo nuevo que pase entre ellos golpea esa misma cara: no hay nada en el
+// medio que la tape. Para esos rayos basta con intersectar la cara, sin
+// recorrer la grilla; el resto (columnas recien expuestas o bordes de
+// paredes) se lanza normalmente.
+
+#include "raycast.h"
+#include <algorithm>
+#include <cmath>
+
+// Cara de pared que golpeo el rayo de una columna: la linea de la grilla
+// (x = line si side == 0, y = line si side == 1) y la celda a lo largo de
+// ella, en coordenadas de celda. side < 0 si no sirve para reutilizar.
+struct ColumnFace {
+    int side;
+    int line, along;
+    float distance;     // Distancia a lo largo del rayo, en celdas
+};
+
+// Los impactos a menos de esta fraccion de celda de una esquina no se
+// reutilizan: ahi el DDA puede decidir la cara de otra forma
+const float COLUMN_FACE_MARGIN = 1e-3f;
+
+// Cara de un impacto a distance celdas por el rayo (dirX, dirY) desde
+// (posX, posY), tambien en celdas
+inline ColumnFace FaceOfHit(float posX, float posY, float dirX, float dirY, float distance, int side) {
+    float across = side == 0 ? posX + distance * dirX : posY + distance * dirY;
+    float along = side == 0 ? posY + distance * dirY : posX + distance * dirX;
+    float cell = floorf(along);
+    float fraction = along - cell;
+    if (fraction < COLUMN_FACE_MARGIN || fraction > 1.0f - COLUMN_FACE_MARGIN) return {-1, 0, 0, 0.0f};
+    return {side, (int)lroundf(across), (int)cell, distance};
+}
+
+// Rehace el impacto del rayo (rayDirX, rayDirY) contra la cara que
+// golpearon las columnas a y b del frame anterior, entre cuyos rayos pasa
+// (angleStep es el angulo entre ellos). Repite las mismas operaciones que
+// TraceRay, asi que el resultado es identico al de lanzar el rayo. Devuelve
+// false si la cara no se puede reutilizar para este rayo.
+inline bool ReprojectHit(const MapView& map, float startX, float startY, float rayDirX, float rayDirY, float blockSize,
+                         const ColumnFace& a, const ColumnFace& b, float angleStep, Intersect& hit) {
+    if (a.side < 0 || a.side != b.side || a.line != b.line || a.along != b.along) return false;
+    // Ancho de la cuña entre los dos rayos a la altura de la pared: con
+    // menos de media celda no puede haber una celda entera adentro
+    if (std::max(a.distance, b.distance) * angleStep >= 0.5f) return false;
+
+    // Mismos pasos que TraceRay sobre el eje que cruza la cara ("across")
+    int side = a.side;
+    float posAcross = (side == 0 ? startX : startY) / blockSize;
+    float posAlong = (side == 0 ? startY : startX) / blockSize;
+    float dirAcross = side == 0 ? rayDirX : rayDirY;
+    float dirAlong = side == 0 ? rayDirY : rayDirX;
+    if (dirAcross == 0.0f) return false;
+
+    int mapAcross = (int)floorf(posAcross);
+    float deltaDist = fabsf(1.0f / dirAcross);
+    float first;
+    int crossings, hitAcross;
+    if (dirAcross < 0) {
+        first = (posAcross - mapAcross) * deltaDist;
+        crossings = mapAcross - a.line;
+        hitAcross = a.line - 1;
+    } else {
+        first = (mapAcross + 1.0f - posAcross) * deltaDist;
+        crossings = a.line - mapAcross - 1;
+        hitAcross = a.line;
+    }
+    if (crossings < 0) return false;
+    float t = first + (float)crossings * deltaDist;
+
+    // El impacto tiene que caer en la misma celda, lejos de sus esquinas
+    float wallX = posAlong + t * dirAlong;
+    float cell = floorf(wallX);
+    wallX -= cell;
+    if ((int)cell != a.along || wallX < COLUMN_FACE_MARGIN || wallX > 1.0f - COLUMN_FACE_MARGIN) return false;
+    if ((side == 0 && rayDirX < 0) || (side == 1 && rayDirY > 0)) {
+        wallX = 1.0f - wallX;
+    }
+
+    int mapX = side == 0 ? hitAcross : a.along;
+    int mapY = side == 0 ? a.along : hitAcross;
+    char impact = '1';
+    if (mapX >= 0 && mapX < map.width && mapY >= 0 && mapY < map.height) {
+        uint8_t value = map.cells[mapY * map.width + mapX];
+        if (value == 0) return false;
+        impact = (char)('0' + value);
+    }
+    hit = {t * blockSize, impact, mapX, mapY, side, wallX};
+    return true;
+}
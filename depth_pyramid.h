@@ -0,0 +1,114 @@
+#pragma once
+
+// Piramide de profundidad maxima sobre el buffer de profundidad de las
+// columnas. El nivel k guarda la distancia de pared mas lejana de cada
+// bloque de DEPTH_PYRAMID_BLOCK << (2 * k) columnas (8, 32 y 128). Si un
+// sprite esta mas lejos que el maximo de un bloque, todas las columnas del
+// bloque lo tapan y no hace falta mirarlas una por una.
+
+#include <algorithm>
+#include <vector>
+
+const int DEPTH_PYRAMID_BLOCK = 8;
+const int DEPTH_PYRAMID_LEVELS = 3;
+
+class DepthPyramid {
+public:
+    static int BlockWidth(int level) { return DEPTH_PYRAMID_BLOCK << (2 * level); }
+
+    // Usa los "columns" valores de "depth" como base de la piramide
+    void Attach(const float* depth, int columns) {
+        source = depth;
+        width = columns;
+        for (int level = 0; level < DEPTH_PYRAMID_LEVELS; level++) {
+            levels[level].assign((width + BlockWidth(level) - 1) / BlockWidth(level), 0.0f);
+        }
+    }
+
+    // Calcula los bloques de todos los niveles que caen enteros dentro de
+    // [startX, endX) (el borde derecho de la pantalla cuenta como limite).
+    // Tiles distintos tocan bloques distintos, asi que se puede llamar en
+    // paralelo desde cada tile de la pasada de paredes.
+    void BuildSpan(int startX, int endX) {
+        for (int level = 0; level < DEPTH_PYRAMID_LEVELS; level++) {
+            int block = BlockWidth(level);
+            int first = (startX + block - 1) / block;
+            for (int b = first; b * block < endX; b++) {
+                int blockEnd = std::min((b + 1) * block, width);
+                if (blockEnd > endX) break;
+                levels[level][b] = level == 0 ? MaxOfColumns(b * block, blockEnd) : MaxOfChildren(level, b);
+            }
+        }
+    }
+
+    // Termina los niveles con bloques mas anchos que un tile de spanWidth
+    // columnas, que ningun tile pudo calcular solo, y el maximo de pantalla
+    void Finish(int spanWidth) {
+        for (int level = 0; level < DEPTH_PYRAMID_LEVELS; level++) {
+            if (BlockWidth(level) <= spanWidth) continue;
+            for (int b = 0; b < (int)levels[level].size(); b++) {
+                levels[level][b] = level == 0 ? MaxOfColumns(b * BlockWidth(0), std::min((b + 1) * BlockWidth(0), width))
+                                              : MaxOfChildren(level, b);
+            }
+        }
+        const std::vector<float>& top = levels[DEPTH_PYRAMID_LEVELS - 1];
+        screenMax = top.empty() ? 0.0f : *std::max_element(top.begin(), top.end());
+    }
+
+    float BlockMax(int level, int block) const { return levels[level][block]; }
+
+    // Cota superior de [startX, endX) con una sola lectura: el bloque mas
+    // chico que contiene todo el rango, o el maximo de toda la pantalla
+    float CoarseMax(int startX, int endX) const {
+        for (int level = 0; level < DEPTH_PYRAMID_LEVELS; level++) {
+            int block = BlockWidth(level);
+            if (startX / block == (endX - 1) / block) return levels[level][startX / block];
+        }
+        return screenMax;
+    }
+
+    // Maximo exacto de [startX, endX) usando los bloques mas grandes que
+    // caben alineados y columnas sueltas en los bordes
+    float SpanMax(int startX, int endX) const {
+        float result = 0.0f;
+        int x = startX;
+        while (x < endX) {
+            int level = DEPTH_PYRAMID_LEVELS - 1;
+            for (; level >= 0; level--) {
+                int block = BlockWidth(level);
+                if (x % block == 0 && std::min(x + block, width) <= endX) break;
+            }
+            if (level < 0) {
+                result = std::max(result, source[x]);
+                x++;
+            } else {
+                result = std::max(result, levels[level][x / BlockWidth(level)]);
+                x = std::min(x + BlockWidth(level), width);
+            }
+        }
+        return result;
+    }
+
+    float ScreenMax() const { return screenMax; }
+
+private:
+    int width = 0;
+    const float* source = nullptr;
+    float screenMax = 0.0f;
+    std::vector<float> levels[DEPTH_PYRAMID_LEVELS];
+
+    float MaxOfColumns(int startX, int endX) const {
+        float result = source[startX];
+        for (int x = startX + 1; x < endX; x++) result = std::max(result, source[x]);
+        return result;
+    }
+
+    float MaxOfChildren(int level, int block) const {
+        const std::vector<float>& below = levels[level - 1];
+        int first = block * 4;
+        int last = std::min(first + 4, (int)below.size());
+        float result = below[first];
+        for (int c = first + 1; c < last; c++) result = std::max(result, below[c]);
+        return result;
+    }
+};
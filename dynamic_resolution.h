@@ -0,0 +1,70 @@
+#pragma once
+
+// Resolucion dinamica: elige la escala de la resolucion interna de la vista
+// 3D segun el tiempo de los ultimos frames, para sostener un tiempo objetivo.
+//
+// El tiempo se suaviza con una media movil exponencial. Se baja un escalon
+// cuando la media pasa del objetivo varios frames seguidos y se sube uno
+// solo cuando la media estimada a la escala siguiente (el costo crece con
+// el area, es decir con el cuadrado de la escala) queda holgadamente por
+// debajo del objetivo durante mas tiempo. Despues de cada cambio hay una
+// espera para que la media refleje la nueva resolucion; con eso la escala no
+// oscila entre dos escalones.
+
+const int RESOLUTION_LEVELS = 5;
+const float RESOLUTION_SCALES[RESOLUTION_LEVELS] = {1.0f, 0.875f, 0.75f, 0.625f, 0.5f};
+
+class ResolutionController {
+public:
+    explicit ResolutionController(float targetMs) : target(targetMs) {}
+
+    // Registra el tiempo de trabajo de un frame (sin la espera de vsync).
+    // Devuelve true si cambio la escala.
+    bool Update(float frameMs) {
+        average = average < 0 ? frameMs : average + (frameMs - average) * SMOOTHING;
+        if (cooldown > 0) {
+            cooldown--;
+            return false;
+        }
+
+        overFrames = average > target ? overFrames + 1 : 0;
+        if (overFrames >= DROP_FRAMES && level + 1 < RESOLUTION_LEVELS) {
+            level++;
+            Changed(DROP_COOLDOWN);
+            return true;
+        }
+
+        float ratio = RESOLUTION_SCALES[level > 0 ? level - 1 : 0] / RESOLUTION_SCALES[level];
+        underFrames = average * ratio * ratio < target * RAISE_HEADROOM ? underFrames + 1 : 0;
+        if (underFrames >= RAISE_FRAMES && level > 0) {
+            level--;
+            Changed(RAISE_COOLDOWN);
+            return true;
+        }
+        return false;
+    }
+
+    float Scale() const { return RESOLUTION_SCALES[level]; }
+    float AverageMs() const { return average; }
+
+private:
+    static constexpr float SMOOTHING = 0.1f;        // Peso del frame nuevo en la media
+    static constexpr float RAISE_HEADROOM = 0.85f;  // Fraccion del objetivo para poder subir
+    static const int DROP_FRAMES = 10;
+    static const int RAISE_FRAMES = 90;
+    static const int DROP_COOLDOWN = 30;
+    static const int RAISE_COOLDOWN = 60;
+
+    void Changed(int frames) {
+        overFrames = 0;
+        underFrames = 0;
+        cooldown = frames;
+    }
+
+    float target;
+    float average = -1.0f;
+    int level = 0;
+    int overFrames = 0;
+    int underFrames = 0;
+    int cooldown = 0;
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+// Campo de distancias para saltar espacio vacio.
+//
+// Para cada celda guarda la distancia de Chebyshev (en celdas) a la celda
+// ocupada mas cercana, saturada en EMPTY_SPACE_MAX. Las paredes valen 0 y
+// lo que esta fuera del mapa cuenta como ocupado. Si una celda vale k >= 2,
+// todas las celdas a distancia k - 1 o menos estan vacias, asi que un rayo
+// puede cruzar ese cuadro de (2k - 1) x (2k - 1) celdas de un solo paso.
+//
+// El salto no es gratis: cada paso lee el campo y calcula cuantas celdas
+// avanzar. En mapas con paredes cada pocas celdas eso cuesta mas de lo que
+// ahorra, asi que cada nivel guarda si le conviene (EmptySpaceWorthSkipping,
+// ver level_format.h).
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+const int EMPTY_SPACE_MAX = 32;
+
+// Media del campo en las celdas vacias desde la que conviene saltar. En el
+// bench, mapas abiertos de 1024x1024 con columnas al azar: con media 3 a 4
+// el salto no gana nada o pierde (hasta un 25% de rayos/s), con media 9 ya
+// gana 1.8x y con media 23 gana 3.5x. En pasillos la media es 1.
+const float EMPTY_SPACE_SKIP_MIN_MEAN = 8.0f;
+
+// Transformada de distancia por chaflan en dos pasadas sobre el rectangulo
+// [x0, x1) x [y0, y1). Con vecindad de 8 y costo 1 por paso es exacta para la
+// distancia de Chebyshev. Los vecinos fuera del mapa valen 0; los que estan
+// dentro del mapa pero fuera del rectangulo se toman como desconocidos.
+inline void ChamferRegion(const uint8_t* cells, int width, int height, int x0, int y0, int x1, int y1,
+                          uint8_t* out, int outStride) {
+    auto neighbor = [&](int x, int y) -> int {
+        if (x < 0 || y < 0 || x >= width || y >= height) return 0;
+        if (x < x0 || y < y0 || x >= x1 || y >= y1) return EMPTY_SPACE_MAX;
+        return out[(y - y0) * outStride + (x - x0)];
+    };
+
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            out[(y - y0) * outStride + (x - x0)] = cells[y * width + x] != 0 ? 0 : EMPTY_SPACE_MAX;
+        }
+    }
+
+    // Hacia adelante: vecinos izquierdo y de la fila de arriba
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            uint8_t& d = out[(y - y0) * outStride + (x - x0)];
+            if (d == 0) continue;
+            int best = std::min({neighbor(x - 1, y), neighbor(x - 1, y - 1), neighbor(x, y - 1), neighbor(x + 1, y - 1)}) + 1;
+            if (best < d) d = (uint8_t)best;
+        }
+    }
+    // Hacia atras: vecinos derecho y de la fila de abajo
+    for (int y = y1 - 1; y >= y0; y--) {
+        for (int x = x1 - 1; x >= x0; x--) {
+            uint8_t& d = out[(y - y0) * outStride + (x - x0)];
+            if (d == 0) continue;
+            int best = std::min({neighbor(x + 1, y), neighbor(x + 1, y + 1), neighbor(x, y + 1), neighbor(x - 1, y + 1)}) + 1;
+            if (best < d) d = (uint8_t)best;
+        }
+    }
+}
+
+// Calcula el campo completo (width * height bytes en "field")
+inline void BuildEmptySpaceField(const uint8_t* cells, int width, int height, uint8_t* field) {
+    ChamferRegion(cells, width, height, 0, 0, width, height, field, width);
+}
+
+// Si el campo es lo bastante grande en promedio para que los rayos ganen
+// saltando (ver EMPTY_SPACE_SKIP_MIN_MEAN)
+inline bool EmptySpaceWorthSkipping(const uint8_t* cells, const uint8_t* field, int width, int height) {
+    uint64_t sum = 0, count = 0;
+    for (size_t i = 0; i < (size_t)width * height; i++) {
+        if (cells[i] != 0) continue;
+        sum += field[i];
+        count++;
+    }
+    return count > 0 && sum >= EMPTY_SPACE_SKIP_MIN_MEAN * count;
+}
+
+// Actualiza el campo despues de cambiar la celda (cellX, cellY). Solo pueden
+// cambiar las celdas a menos de EMPTY_SPACE_MAX de ella; se recalcula una
+// ventana del doble de ese radio para que su distancia salga exacta y se
+// copia solo la parte interior.
+inline void UpdateEmptySpaceField(const uint8_t* cells, int width, int height, uint8_t* field, int cellX, int cellY) {
+    const int inner = EMPTY_SPACE_MAX;
+    const int outer = 2 * EMPTY_SPACE_MAX;
+    int x0 = std::max(cellX - outer, 0), x1 = std::min(cellX + outer + 1, width);
+    int y0 = std::max(cellY - outer, 0), y1 = std::min(cellY + outer + 1, height);
+    if (x0 >= x1 || y0 >= y1) return;
+
+    int stride = x1 - x0;
+    std::vector<uint8_t> window((size_t)stride * (y1 - y0));
+    ChamferRegion(cells, width, height, x0, y0, x1, y1, window.data(), stride);
+
+    int ix0 = std::max(cellX - inner, 0), ix1 = std::min(cellX + inner + 1, width);
+    int iy0 = std::max(cellY - inner, 0), iy1 = std::min(cellY + inner + 1, height);
+    for (int y = iy0; y < iy1; y++) {
+        for (int x = ix0; x < ix1; x++) {
+            field[y * width + x] = window[(y - y0) * stride + (x - x0)];
+        }
+    }
+}
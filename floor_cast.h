@@ -0,0 +1,196 @@
+#pragma once
+
+// Kernels de piso y techo por filas. En una fila de pantalla la distancia
+// al piso es la misma para todos los pixeles, asi que la posicion en el
+// mundo avanza en linea recta de un pixel al siguiente y el sombreado por
+// distancia es uno solo para toda la fila. El kernel AVX2 procesa 8 pixeles
+// por iteracion (gather de texeles y sombreado en enteros de 16 bits) y da
+// exactamente el mismo resultado que el escalar.
+//
+// En un mapa con iluminacion (ver lighting.h) la luz cambia de una celda a
+// la siguiente: esas filas buscan la luz de la celda de cada pixel y la
+// combinan con el brillo de la fila (con tablas en el camino escalar).
+
+#include "raylib.h"
+#include "raycast.h"
+#include "lighting.h"
+#include <cmath>
+#include <cstdint>
+
+// Una fila de piso o techo. u, v son coordenadas en texeles de la textura
+// (column-major, lado potencia de dos, se repite en las dos direcciones)
+// del primer pixel; stepU, stepV lo que avanzan por pixel.
+struct FloorRow {
+    float u, v;
+    float stepU, stepV;
+    const Color* texels;
+    int texSize;
+    int brightness;     // 0..255, se aplica como c * brightness / 255
+    const uint8_t* light = nullptr;     // Luz por celda del mapa (ver lighting.h); nullptr si no hay
+    int mapWidth = 0, mapHeight = 0;
+};
+
+// c * b / 255 redondeado hacia abajo, sin division (exacto para c, b <= 255)
+inline uint32_t ShadeChannel(uint32_t c, uint32_t b) {
+    uint32_t x = c * b;
+    return (x + 1 + (x >> 8)) >> 8;
+}
+
+inline void FloorRowScalar(const FloorRow& row, Color* out, int first, int count) {
+    int mask = row.texSize - 1;
+    for (int i = first; i < count; i++) {
+        float u = row.u + (float)i * row.stepU;
+        float v = row.v + (float)i * row.stepV;
+        int texX = (int)floorf(u) & mask;
+        int texY = (int)floorf(v) & mask;
+        Color color = row.texels[texX * row.texSize + texY];
+        out[i] = {(unsigned char)ShadeChannel(color.r, row.brightness), (unsigned char)ShadeChannel(color.g, row.brightness),
+                  (unsigned char)ShadeChannel(color.b, row.brightness), color.a};
+    }
+}
+
+// Fila con luz por celda. Un texel cae en la celda floor(u / texSize), y el
+// lado de la textura es potencia de dos, asi que la celda sale con un shift
+inline void FloorRowLitScalar(const FloorRow& row, Color* out, int first, int count) {
+    int mask = row.texSize - 1;
+    int cellShift = 0;
+    while ((1 << cellShift) < row.texSize) cellShift++;
+    const uint8_t (*shadeTable)[256] = ShadeTable();
+    const uint8_t* lightShade = shadeTable[row.brightness];
+    for (int i = first; i < count; i++) {
+        int texelX = (int)floorf(row.u + (float)i * row.stepU);
+        int texelY = (int)floorf(row.v + (float)i * row.stepV);
+        int cellX = texelX >> cellShift, cellY = texelY >> cellShift;
+        int light = (unsigned)cellX < (unsigned)row.mapWidth && (unsigned)cellY < (unsigned)row.mapHeight
+                        ? row.light[(size_t)cellY * row.mapWidth + cellX] : LIGHT_FULL;
+        const uint8_t* shade = shadeTable[lightShade[light]];
+        Color color = row.texels[(texelX & mask) * row.texSize + (texelY & mask)];
+        out[i] = {shade[color.r], shade[color.g], shade[color.b], color.a};
+    }
+}
+
+#ifdef RAYCAST_X86_SIMD
+
+__attribute__((target("avx2")))
+inline int FloorRowAVX2(const FloorRow& row, Color* out, int count) {
+    const __m256 lane = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 u0 = _mm256_set1_ps(row.u);
+    const __m256 v0 = _mm256_set1_ps(row.v);
+    const __m256 stepU = _mm256_set1_ps(row.stepU);
+    const __m256 stepV = _mm256_set1_ps(row.stepV);
+    const __m256i mask = _mm256_set1_epi32(row.texSize - 1);
+    const __m256i texSize = _mm256_set1_epi32(row.texSize);
+    const __m256i brightness = _mm256_set1_epi16((short)row.brightness);
+    const __m256i one = _mm256_set1_epi16(1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alpha = _mm256_set1_epi32((int)0xFF000000u);
+    const int* texels = (const int*)row.texels;
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 index = _mm256_add_ps(_mm256_set1_ps((float)i), lane);
+        __m256 u = _mm256_add_ps(u0, _mm256_mul_ps(index, stepU));
+        __m256 v = _mm256_add_ps(v0, _mm256_mul_ps(index, stepV));
+        __m256i texX = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_floor_ps(u)), mask);
+        __m256i texY = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_floor_ps(v)), mask);
+        __m256i offset = _mm256_add_epi32(_mm256_mullo_epi32(texX, texSize), texY);
+        __m256i color = _mm256_i32gather_epi32(texels, offset, 4);
+
+        // Sombrear los 4 canales en 16 bits y reponer el alfa original
+        __m256i lo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(color, zero), brightness);
+        __m256i hi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(color, zero), brightness);
+        lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(lo, one), _mm256_srli_epi16(lo, 8)), 8);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(hi, one), _mm256_srli_epi16(hi, 8)), 8);
+        __m256i shaded = _mm256_packus_epi16(lo, hi);
+        shaded = _mm256_blendv_epi8(shaded, color, alpha);
+        _mm256_storeu_si256((__m256i*)(out + i), shaded);
+    }
+    return i;
+}
+
+// Igual que FloorRowLitScalar, 8 pixeles por iteracion: la luz de cada
+// celda se lee con un gather enmascarado (fuera del mapa queda LIGHT_FULL)
+// y el brillo de cada pixel se combina con el de la fila con la misma
+// aritmetica que ShadeChannel, que da lo mismo que las tablas.
+__attribute__((target("avx2")))
+inline int FloorRowLitAVX2(const FloorRow& row, Color* out, int count) {
+    int cellShift = 0;
+    while ((1 << cellShift) < row.texSize) cellShift++;
+    const __m128i shift = _mm_cvtsi32_si128(cellShift);
+    const __m256 lane = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 u0 = _mm256_set1_ps(row.u);
+    const __m256 v0 = _mm256_set1_ps(row.v);
+    const __m256 stepU = _mm256_set1_ps(row.stepU);
+    const __m256 stepV = _mm256_set1_ps(row.stepV);
+    const __m256i mask = _mm256_set1_epi32(row.texSize - 1);
+    const __m256i texSize = _mm256_set1_epi32(row.texSize);
+    const __m256i mapWidth = _mm256_set1_epi32(row.mapWidth);
+    const __m256i mapHeight = _mm256_set1_epi32(row.mapHeight);
+    const __m256i minusOne = _mm256_set1_epi32(-1);
+    const __m256i fullLight = _mm256_set1_epi32(LIGHT_FULL);
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const __m256i rowBrightness = _mm256_set1_epi32(row.brightness);
+    const __m256i one32 = _mm256_set1_epi32(1);
+    const __m256i one = _mm256_set1_epi16(1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alpha = _mm256_set1_epi32((int)0xFF000000u);
+    const int* texels = (const int*)row.texels;
+    const int* light = (const int*)row.light;
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 index = _mm256_add_ps(_mm256_set1_ps((float)i), lane);
+        __m256 u = _mm256_add_ps(u0, _mm256_mul_ps(index, stepU));
+        __m256 v = _mm256_add_ps(v0, _mm256_mul_ps(index, stepV));
+        __m256i texelX = _mm256_cvttps_epi32(_mm256_floor_ps(u));
+        __m256i texelY = _mm256_cvttps_epi32(_mm256_floor_ps(v));
+        __m256i offset = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_and_si256(texelX, mask), texSize), _mm256_and_si256(texelY, mask));
+        __m256i color = _mm256_i32gather_epi32(texels, offset, 4);
+
+        // Luz de la celda de cada pixel (4 bytes desde la celda; vale el primero)
+        __m256i cellX = _mm256_sra_epi32(texelX, shift);
+        __m256i cellY = _mm256_sra_epi32(texelY, shift);
+        __m256i inside = _mm256_and_si256(_mm256_and_si256(_mm256_cmpgt_epi32(cellX, minusOne), _mm256_cmpgt_epi32(mapWidth, cellX)),
+                                          _mm256_and_si256(_mm256_cmpgt_epi32(cellY, minusOne), _mm256_cmpgt_epi32(mapHeight, cellY)));
+        __m256i cell = _mm256_add_epi32(_mm256_mullo_epi32(cellY, mapWidth), cellX);
+        __m256i cellLight = _mm256_and_si256(_mm256_mask_i32gather_epi32(fullLight, light, cell, inside, 1), byteMask);
+
+        // Brillo por pixel = luz * brillo de la fila / 255, repetido en los
+        // 4 canales de 16 bits de cada pixel
+        __m256i x = _mm256_mullo_epi32(cellLight, rowBrightness);
+        __m256i brightness = _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(x, one32), _mm256_srli_epi32(x, 8)), 8);
+        brightness = _mm256_or_si256(brightness, _mm256_slli_epi32(brightness, 16));
+        __m256i brightnessLo = _mm256_unpacklo_epi32(brightness, brightness);
+        __m256i brightnessHi = _mm256_unpackhi_epi32(brightness, brightness);
+
+        __m256i lo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(color, zero), brightnessLo);
+        __m256i hi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(color, zero), brightnessHi);
+        lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(lo, one), _mm256_srli_epi16(lo, 8)), 8);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(hi, one), _mm256_srli_epi16(hi, 8)), 8);
+        __m256i shaded = _mm256_packus_epi16(lo, hi);
+        shaded = _mm256_blendv_epi8(shaded, color, alpha);
+        _mm256_storeu_si256((__m256i*)(out + i), shaded);
+    }
+    return i;
+}
+
+#endif // RAYCAST_X86_SIMD
+
+// Dibuja count pixeles de la fila con el kernel pedido (AVX2 si se pidio o
+// si es el mejor disponible; cualquier otro usa el camino escalar)
+inline void DrawFloorRow(const FloorRow& row, Color* out, int count, RayKernel kernel = RAY_KERNEL_AUTO) {
+    if (kernel == RAY_KERNEL_AUTO || kernel > DetectRayKernel()) kernel = DetectRayKernel();
+
+    int done = 0;
+    if (row.light != nullptr) {
+#ifdef RAYCAST_X86_SIMD
+        if (kernel == RAY_KERNEL_AVX2) done = FloorRowLitAVX2(row, out, count);
+#endif
+        FloorRowLitScalar(row, out, done, count);
+        return;
+    }
+#ifdef RAYCAST_X86_SIMD
+    if (kernel == RAY_KERNEL_AVX2) done = FloorRowAVX2(row, out, count);
+#endif
+    FloorRowScalar(row, out, done, count);
+}
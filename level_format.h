@@ -0,0 +1,264 @@
+#pragma once
+
+// Formato binario de niveles (.lvl), version 5. Little-endian.
+//
+//   LevelHeader              (cabecera fija, 96 bytes; 48 en la version 1,
+//                            56 en la 2, 72 en la 3 y 88 en la 4)
+//   celdas                   width * height bytes, fila mayor, 0 = vacio
+//   relleno                  hasta alinear a 4 y al menos 4 bytes en cero
+//   campo de espacio vacio   mismo tamaño y relleno que las celdas (version 2,
+//                            ver empty_space.h)
+//   LevelSprite[spriteCount]
+//   LevelLight[lightCount]   (version 3, ver lighting.h)
+//   PVS                      (version 4, opcional, ver pvs.h)
+//
+// El relleno despues de las celdas permite que el kernel AVX2 lea 4 bytes
+// a partir de cualquier celda. La version 1 no trae el campo de espacio
+// vacio; en ese caso se calcula al cargar. Las versiones 1 y 2 no traen
+// luces: esos niveles se dibujan sin iluminacion. Sin PVS no se descarta
+// nada por visibilidad. Desde la version 5 la cabecera dice si los rayos
+// saltan espacio vacio en el nivel (make_levels lo decide con
+// EmptySpaceWorthSkipping); antes se saltaba siempre.
+//
+// El archivo se abre con mmap y se usa tal cual: no hay paso de parseo (al
+// abrir solo se revisan los sprites y las luces, que son pocos), asi que
+// abrir un mapa de 4096x4096 cuesta lo mismo que abrir uno de 8x8.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+#include "empty_space.h"
+#include "pvs.h"
+
+const uint32_t LEVEL_FORMAT_VERSION = 5;
+const int LEVEL_MAX_SIZE = 1 << 15;
+const int LEVEL_SPRITE_TYPES = 3;       // Tipos de sprite (texturas en SPRITE_TEXTURES)
+const uint32_t LEVEL_FLAG_SKIP_EMPTY_SPACE = 1;     // Los rayos saltan espacio vacio
+
+struct LevelHeader {
+    char magic[4];          // "RCLV"
+    uint32_t version;
+    uint32_t width, height;
+    uint32_t spriteCount;
+    float spawnX, spawnY;   // Posicion inicial en coordenadas de celda
+    float spawnAngle;
+    uint64_t cellsOffset;   // Desde el inicio del nivel (del archivo o de su entrada en un paquete)
+    uint64_t spritesOffset;
+    uint64_t emptySpaceOffset;  // Desde la version 2; 0 si no hay campo
+    uint32_t lightCount;        // Desde la version 3
+    uint32_t ambientLight;      // 0..255; 255 y sin luces = nivel sin iluminacion
+    uint64_t lightsOffset;
+    uint64_t pvsOffset;         // Desde la version 4; 0 si no hay PVS
+    uint64_t pvsSize;
+    uint32_t flags;             // Desde la version 5: LEVEL_FLAG_*
+    uint32_t reserved;
+};
+
+struct LevelSprite {
+    float x, y;             // Coordenadas de celda
+    int32_t type;
+};
+
+struct LevelLight {
+    float x, y;             // Coordenadas de celda
+    float radius;           // En celdas
+    int32_t intensity;      // 0..255
+};
+
+static_assert(sizeof(LevelHeader) == 96, "LevelHeader debe medir 96 bytes");
+const size_t LEVEL_HEADER_V1_SIZE = 48;
+const size_t LEVEL_HEADER_V2_SIZE = 56;
+const size_t LEVEL_HEADER_V3_SIZE = 72;
+const size_t LEVEL_HEADER_V4_SIZE = 88;
+static_assert(sizeof(LevelSprite) == 12, "LevelSprite debe medir 12 bytes");
+static_assert(sizeof(LevelLight) == 16, "LevelLight debe medir 16 bytes");
+
+// Nivel abierto: las celdas apuntan directo al archivo mapeado
+// (copia-al-escribir, asi que el juego puede modificarlas)
+struct LevelFile {
+    MappedFile file;
+    const LevelHeader* header = nullptr;
+    uint8_t* cells = nullptr;
+    uint8_t* emptySpace = nullptr;  // nullptr si el archivo no lo trae
+    const LevelSprite* sprites = nullptr;
+    const LevelLight* lights = nullptr;
+    uint32_t lightCount = 0;
+    uint32_t ambientLight = 255;
+    const uint8_t* pvs = nullptr;   // Bloque del PVS; nullptr si el archivo no lo trae
+    size_t pvsSize = 0;
+    bool skipEmptySpace = true;     // Saltar espacio vacio con los rayos
+};
+
+inline size_t LevelCellsBytes(uint32_t width, uint32_t height) {
+    size_t count = (size_t)width * height;
+    return ((count + 3) & ~(size_t)3) + 4;
+}
+
+// Cada sprite tiene un tipo conocido y esta dentro del mapa
+inline bool LevelSpritesValid(const LevelSprite* sprites, uint32_t count, uint32_t width, uint32_t height) {
+    for (uint32_t i = 0; i < count; i++) {
+        const LevelSprite& sprite = sprites[i];
+        if (sprite.type < 0 || sprite.type >= LEVEL_SPRITE_TYPES) return false;
+        if (!(sprite.x >= 0 && sprite.x < width && sprite.y >= 0 && sprite.y < height)) return false;
+    }
+    return true;
+}
+
+// Cada luz esta dentro del mapa, con radio positivo y no mayor que el mapa
+// (LightGrid pasa a int las celdas que cubre) e intensidad 0..255
+inline bool LevelLightsValid(const LevelLight* lights, uint32_t count, uint32_t width, uint32_t height) {
+    float maxRadius = (float)std::max(width, height);
+    for (uint32_t i = 0; i < count; i++) {
+        const LevelLight& light = lights[i];
+        if (!(light.x >= 0 && light.x < width && light.y >= 0 && light.y < height)) return false;
+        if (!(light.radius > 0 && light.radius <= maxRadius)) return false;
+        if (light.intensity < 0 || light.intensity > 255) return false;
+    }
+    return true;
+}
+
+// Abre el nivel guardado en los bytes [offset, offset + length) del archivo
+// (length = 0: hasta el final). Asi se abre tambien un nivel dentro de un
+// paquete de assets (ver asset_bundle.h); cada llamada mapea el archivo de
+// nuevo, asi que los cambios del juego en las celdas no pasan a la
+// siguiente vez que se abre el mismo nivel.
+inline bool OpenLevelFileRange(const char* path, uint64_t offset, uint64_t length, LevelFile& level, std::string* error) {
+    level = LevelFile();
+    if (!level.file.Open(path)) {
+        if (error) *error = std::string("no se pudo abrir ") + path;
+        return false;
+    }
+    if (offset > level.file.Size() || length > level.file.Size() - offset) {
+        if (error) *error = std::string(path) + ": nivel fuera del archivo";
+        level = LevelFile();
+        return false;
+    }
+
+    size_t size = length != 0 ? (size_t)length : level.file.Size() - (size_t)offset;
+    unsigned char* data = level.file.Data() + offset;
+    const LevelHeader* header = (const LevelHeader*)data;
+    const char* problem = NULL;
+    uint32_t version = size >= LEVEL_HEADER_V1_SIZE ? header->version : 0;
+    size_t headerSize = version == 1 ? LEVEL_HEADER_V1_SIZE : version == 2 ? LEVEL_HEADER_V2_SIZE
+                      : version == 3 ? LEVEL_HEADER_V3_SIZE : version == 4 ? LEVEL_HEADER_V4_SIZE : sizeof(LevelHeader);
+    uint64_t emptySpaceOffset = version >= 2 && size >= headerSize ? header->emptySpaceOffset : 0;
+    bool hasLights = version >= 3 && size >= headerSize;
+    uint32_t lightCount = hasLights ? header->lightCount : 0;
+    uint64_t pvsOffset = version >= 4 && size >= headerSize ? header->pvsOffset : 0;
+    if (size < LEVEL_HEADER_V1_SIZE || memcmp(header->magic, "RCLV", 4) != 0) {
+        problem = "no es un archivo de nivel";
+    } else if (version < 1 || version > LEVEL_FORMAT_VERSION) {
+        problem = "version de formato no soportada";
+    } else if (size < headerSize) {
+        problem = "cabecera incompleta";
+    } else if (header->width == 0 || header->height == 0 || header->width > LEVEL_MAX_SIZE || header->height > LEVEL_MAX_SIZE) {
+        problem = "dimensiones invalidas";
+    } else if (header->cellsOffset < headerSize || header->cellsOffset > size ||
+               size - header->cellsOffset < LevelCellsBytes(header->width, header->height)) {
+        problem = "celdas fuera del archivo";
+    } else if (emptySpaceOffset != 0 && (emptySpaceOffset < headerSize || emptySpaceOffset > size ||
+               size - emptySpaceOffset < LevelCellsBytes(header->width, header->height))) {
+        problem = "campo de espacio vacio fuera del archivo";
+    } else if (header->spritesOffset % 4 != 0 || header->spritesOffset > size ||
+               (size - header->spritesOffset) / sizeof(LevelSprite) < header->spriteCount) {
+        problem = "sprites fuera del archivo";
+    } else if (lightCount > 0 && (header->lightsOffset % 4 != 0 || header->lightsOffset > size ||
+               (size - header->lightsOffset) / sizeof(LevelLight) < lightCount)) {
+        problem = "luces fuera del archivo";
+    } else if (hasLights && header->ambientLight > 255) {
+        problem = "luz ambiente invalida";
+    } else if (pvsOffset != 0 && (pvsOffset < headerSize || pvsOffset > size || header->pvsSize > size - pvsOffset)) {
+        problem = "PVS fuera del archivo";
+    } else if (!(header->spawnX >= 0 && header->spawnX < header->width && header->spawnY >= 0 && header->spawnY < header->height) ||
+               !std::isfinite(header->spawnAngle)) {
+        problem = "posicion inicial fuera del mapa";
+    } else if (!LevelSpritesValid((const LevelSprite*)(data + header->spritesOffset), header->spriteCount, header->width, header->height)) {
+        problem = "sprite invalido";
+    } else if (lightCount > 0 && !LevelLightsValid((const LevelLight*)(data + header->lightsOffset), lightCount, header->width, header->height)) {
+        problem = "luz invalida";
+    }
+    if (problem != NULL) {
+        if (error) *error = std::string(path) + ": " + problem;
+        level = LevelFile();
+        return false;
+    }
+
+    level.header = header;
+    level.cells = data + header->cellsOffset;
+    level.emptySpace = emptySpaceOffset != 0 ? data + emptySpaceOffset : nullptr;
+    level.sprites = (const LevelSprite*)(data + header->spritesOffset);
+    if (hasLights) {
+        level.lights = lightCount > 0 ? (const LevelLight*)(data + header->lightsOffset) : nullptr;
+        level.lightCount = lightCount;
+        level.ambientLight = header->ambientLight;
+    }
+    if (pvsOffset != 0) {
+        level.pvs = data + pvsOffset;
+        level.pvsSize = (size_t)header->pvsSize;
+    }
+    if (version >= 5) level.skipEmptySpace = (header->flags & LEVEL_FLAG_SKIP_EMPTY_SPACE) != 0;
+    return true;
+}
+
+inline bool OpenLevelFile(const char* path, LevelFile& level, std::string* error) {
+    return OpenLevelFileRange(path, 0, 0, level, error);
+}
+
+// Escribe un nivel. Sin luces y con ambientLight = 255 el nivel no tiene
+// iluminacion. Con withPvs se calcula y se guarda su PVS (solo conviene en
+// mapas tipo laberinto, ver pvs.h). El salto de espacio vacio queda marcado
+// si EmptySpaceWorthSkipping dice que conviene.
+inline bool WriteLevelFile(const char* path, uint32_t width, uint32_t height, const uint8_t* cells,
+                           const LevelSprite* sprites, uint32_t spriteCount, float spawnX, float spawnY, float spawnAngle,
+                           const LevelLight* lights = nullptr, uint32_t lightCount = 0, uint32_t ambientLight = 255,
+                           bool withPvs = false) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) return false;
+
+    size_t cellsBytes = LevelCellsBytes(width, height);
+    LevelHeader header = {};
+    memcpy(header.magic, "RCLV", 4);
+    header.version = LEVEL_FORMAT_VERSION;
+    header.width = width;
+    header.height = height;
+    header.spriteCount = spriteCount;
+    header.spawnX = spawnX;
+    header.spawnY = spawnY;
+    header.spawnAngle = spawnAngle;
+    header.cellsOffset = sizeof(LevelHeader);
+    header.emptySpaceOffset = sizeof(LevelHeader) + cellsBytes;
+    header.spritesOffset = sizeof(LevelHeader) + 2 * cellsBytes;
+    header.lightCount = lightCount;
+    header.ambientLight = ambientLight;
+    header.lightsOffset = header.spritesOffset + (uint64_t)spriteCount * sizeof(LevelSprite);
+
+    // El campo de espacio vacio se precalcula aqui para no hacerlo al cargar
+    size_t cellCount = (size_t)width * height;
+    std::vector<uint8_t> emptySpace(cellsBytes, 0);
+    BuildEmptySpaceField(cells, (int)width, (int)height, emptySpace.data());
+    if (EmptySpaceWorthSkipping(cells, emptySpace.data(), (int)width, (int)height)) header.flags |= LEVEL_FLAG_SKIP_EMPTY_SPACE;
+
+    std::vector<uint8_t> pvs;
+    if (withPvs) {
+        PotentiallyVisibleSet set;
+        set.Build({cells, (int)width, (int)height, emptySpace.data()});
+        if (set.IsLoaded()) pvs = set.Serialize();
+    }
+    header.pvsOffset = pvs.empty() ? 0 : header.lightsOffset + (uint64_t)lightCount * sizeof(LevelLight);
+    header.pvsSize = pvs.size();
+
+    static const uint8_t padding[8] = {0};
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(cells, 1, cellCount, file) == cellCount &&
+              fwrite(padding, 1, cellsBytes - cellCount, file) == cellsBytes - cellCount &&
+              fwrite(emptySpace.data(), 1, cellsBytes, file) == cellsBytes &&
+              (spriteCount == 0 || fwrite(sprites, sizeof(LevelSprite), spriteCount, file) == spriteCount) &&
+              (lightCount == 0 || fwrite(lights, sizeof(LevelLight), lightCount, file) == lightCount) &&
+              (pvs.empty() || fwrite(pvs.data(), 1, pvs.size(), file) == pvs.size());
+    return fclose(file) == 0 && ok;
+}
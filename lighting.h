@@ -0,0 +1,185 @@
+#pragma once
+
+// Iluminacion horneada por celda.
+//
+// Cada celda del mapa guarda cuanta luz le llega (0..255): la luz ambiente
+// del nivel mas la de cada luz puntual que la ve sin paredes en el medio,
+// con caida cuadratica hasta su radio. La grilla se hornea al cargar el
+// nivel; cuando una luz dinamica se mueve o cambia una celda del mapa solo
+// se recalculan las celdas que esa luz o esa celda pueden afectar.
+//
+// Al dibujar, la luz de la celda se combina con el sombreado por distancia
+// en enteros: ShadeTable()[distancia][luz] da el brillo final y su fila de
+// ShadeTable sombrea cada canal con una lectura, sin multiplicar ni dividir
+// por pixel. Con la luz en LIGHT_FULL el brillo es el de la distancia sin
+// cambios, asi que un nivel sin luces se ve igual que antes.
+
+#include "raycast.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+const int LIGHT_FULL = 255;
+
+// Tabla de sombreado: ShadeTable()[b][c] = c * b / 255. Sirve para aplicar
+// un brillo b a un canal c y tambien para combinar la luz de una celda con
+// el brillo por distancia (los dos son fracciones de 255).
+inline const uint8_t (*ShadeTable())[256] {
+    static uint8_t table[256][256];
+    static bool ready = [] {
+        for (int b = 0; b < 256; b++) {
+            for (int c = 0; c < 256; c++) table[b][c] = (uint8_t)(c * b / 255);
+        }
+        return true;
+    }();
+    (void)ready;
+    return table;
+}
+
+// Luz puntual en coordenadas de celda
+struct PointLight {
+    float x, y;
+    float radius;       // Celdas hasta donde llega
+    int intensity;      // Luz que suma en su centro (0..255)
+};
+
+// Luz de la celda (x, y) en coordenadas de celda; fuera del mapa o sin
+// grilla de luz, LIGHT_FULL
+inline int LightAt(const MapView& map, int x, int y) {
+    if (map.light == nullptr || x < 0 || y < 0 || x >= map.width || y >= map.height) return LIGHT_FULL;
+    return map.light[(size_t)y * map.width + x];
+}
+
+// Luz que ilumina una cara de pared: la de la celda vacia de donde viene el
+// rayo. side y rayDistance (en celdas) son los del impacto desde (posX, posY).
+inline int WallLight(const MapView& map, float posX, float posY, float dirX, float dirY, float rayDistance, int side) {
+    float hitX = posX + rayDistance * dirX;
+    float hitY = posY + rayDistance * dirY;
+    int x, y;
+    if (side == 0) {
+        int line = (int)lroundf(hitX);
+        x = dirX > 0 ? line - 1 : line;
+        y = (int)floorf(hitY);
+    } else {
+        int line = (int)lroundf(hitY);
+        y = dirY > 0 ? line - 1 : line;
+        x = (int)floorf(hitX);
+    }
+    return LightAt(map, x, y);
+}
+
+class LightGrid {
+public:
+    // Hornea la grilla completa de map con la luz ambiente y las luces
+    // estaticas. Las luces dinamicas anteriores se descartan.
+    void Bake(const MapView& map, int ambientLight, const std::vector<PointLight>& staticLights) {
+        width = map.width;
+        height = map.height;
+        ambient = std::clamp(ambientLight, 0, LIGHT_FULL);
+        lights = staticLights;
+        cells.assign((size_t)width * height + 3, 0);     // Relleno para el gather de AVX2
+        accumulator.clear();
+        Relight(map, 0, 0, width, height);
+    }
+
+    // Sin iluminacion: Data() devuelve nullptr y todo se dibuja con LIGHT_FULL
+    void Clear() {
+        cells.clear();
+        cells.shrink_to_fit();
+        lights.clear();
+        width = height = 0;
+    }
+
+    bool IsLit() const { return !cells.empty(); }
+    const uint8_t* Data() const { return cells.empty() ? nullptr : cells.data(); }
+    int LightCount() const { return (int)lights.size(); }
+    const PointLight& Light(int id) const { return lights[id]; }
+
+    // Agrega una luz que se puede mover con MoveLight; devuelve su id
+    int AddLight(const MapView& map, const PointLight& light) {
+        lights.push_back(light);
+        RelightAround(map, light.x, light.y, light.radius);
+        return (int)lights.size() - 1;
+    }
+
+    // Mueve la luz id y recalcula solo las celdas que alcanzaba antes o
+    // alcanza ahora
+    void MoveLight(const MapView& map, int id, float x, float y) {
+        PointLight& light = lights[id];
+        if (light.x == x && light.y == y) return;
+        int x0 = (int)floorf(std::min(light.x, x) - light.radius), y0 = (int)floorf(std::min(light.y, y) - light.radius);
+        int x1 = (int)ceilf(std::max(light.x, x) + light.radius) + 1, y1 = (int)ceilf(std::max(light.y, y) + light.radius) + 1;
+        light.x = x;
+        light.y = y;
+        Relight(map, x0, y0, x1, y1);
+    }
+
+    // Despues de cambiar la celda (x, y) del mapa: una luz a menos de su
+    // radio de la celda puede ver a traves de ella celdas hasta a dos radios
+    void UpdateCell(const MapView& map, int x, int y) {
+        if (!IsLit()) return;
+        float reach = 2 * MaxRadius();
+        RelightAround(map, x + 0.5f, y + 0.5f, reach);
+    }
+
+private:
+    float MaxRadius() const {
+        float radius = 0;
+        for (const PointLight& light : lights) radius = std::max(radius, light.radius);
+        return radius;
+    }
+
+    void RelightAround(const MapView& map, float x, float y, float radius) {
+        Relight(map, (int)floorf(x - radius), (int)floorf(y - radius), (int)ceilf(x + radius) + 1, (int)ceilf(y + radius) + 1);
+    }
+
+    // Recalcula las celdas de [x0, x1) x [y0, y1) (recortado al mapa): la
+    // luz ambiente mas cada luz que alcanza el rectangulo, sobre sus celdas
+    void Relight(const MapView& map, int x0, int y0, int x1, int y1) {
+        if (!IsLit()) return;
+        x0 = std::max(x0, 0);
+        y0 = std::max(y0, 0);
+        x1 = std::min(x1, width);
+        y1 = std::min(y1, height);
+        if (x0 >= x1 || y0 >= y1) return;
+
+        int regionWidth = x1 - x0;
+        accumulator.assign((size_t)regionWidth * (y1 - y0), ambient);
+        for (const PointLight& light : lights) {
+            int lx0 = std::max(x0, (int)floorf(light.x - light.radius)), ly0 = std::max(y0, (int)floorf(light.y - light.radius));
+            int lx1 = std::min(x1, (int)ceilf(light.x + light.radius) + 1), ly1 = std::min(y1, (int)ceilf(light.y + light.radius) + 1);
+            for (int y = ly0; y < ly1; y++) {
+                for (int x = lx0; x < lx1; x++) {
+                    accumulator[(size_t)(y - y0) * regionWidth + (x - x0)] += Contribution(map, light, x, y);
+                }
+            }
+        }
+        for (int y = y0; y < y1; y++) {
+            const int* source = accumulator.data() + (size_t)(y - y0) * regionWidth;
+            uint8_t* row = cells.data() + (size_t)y * width;
+            for (int x = x0; x < x1; x++) row[x] = (uint8_t)std::min(source[x - x0], LIGHT_FULL);
+        }
+    }
+
+    // Luz que llega del centro de light al centro de la celda (x, y): cero
+    // si esta fuera del radio o si una pared la tapa. La visibilidad usa el
+    // mismo recorrido de grilla que los rayos de la vista.
+    static int Contribution(const MapView& map, const PointLight& light, int x, int y) {
+        float dx = x + 0.5f - light.x, dy = y + 0.5f - light.y;
+        float distance = sqrtf(dx * dx + dy * dy);
+        if (distance >= light.radius) return 0;
+        if (distance > 1e-4f) {
+            Intersect hit = TraceRay(map, light.x, light.y, dx / distance, dy / distance, 1.0f);
+            if ((hit.mapX != x || hit.mapY != y) && hit.distance < distance) return 0;
+        }
+        float falloff = 1.0f - distance / light.radius;
+        return (int)(light.intensity * falloff * falloff);
+    }
+
+    int width = 0, height = 0;
+    int ambient = LIGHT_FULL;
+    std::vector<PointLight> lights;
+    std::vector<uint8_t> cells;
+    std::vector<int> accumulator;
+};
@@ -3,15 +3,15 @@
 #include <vector>
 #include <algorithm>
 #include <cstdio>
-
-const int SCREEN_WIDTH = 800;
-const int SCREEN_HEIGHT = 600;
-const int MAP_WIDTH = 8;
-const int MAP_HEIGHT = 8;
-const float FOV = 60.0f * DEG2RAD;
-const float BLOCK_SIZE = 64.0f;
-const int NUM_RAYS = SCREEN_WIDTH;
-const int SPRITE_SIZE = 32; // Tamaño de la textura del sprite
+#include <chrono>
+#include <memory>
+#include "raycaster.h"
+#include "dynamic_resolution.h"
+#include "simulation.h"
+#include "audio.h"
+#include "asset_loader.h"
+#include "replay.h"
+#include "ui_layers.h"
 
 // Estados del juego
 enum GameState {
@@ -20,242 +20,22 @@ enum GameState {
     VICTORY
 };
 
-// Mapas de los niveles
-int level1Map[MAP_HEIGHT][MAP_WIDTH] = {
-    {1,1,1,1,1,1,1,1},
-    {1,0,0,0,0,0,0,1},
-    {1,0,2,0,0,3,0,1},
-    {1,0,0,0,4,0,0,1}, // 4 = cubo morado (objetivo)
-    {1,0,2,0,0,3,0,1},
-    {1,0,0,0,0,0,0,1},
-    {1,0,0,0,0,0,0,1},
-    {1,1,1,1,1,1,1,1}
-};
-
-int level2Map[MAP_HEIGHT][MAP_WIDTH] = {
-    {1,1,1,1,1,1,1,1},
-    {1,0,0,2,2,0,0,1},
-    {1,0,0,0,0,3,0,1},
-    {1,2,3,0,0,0,2,1},
-    {1,0,0,0,4,0,0,1}, // 4 = cubo morado (objetivo)
-    {1,2,0,3,0,3,0,1},
-    {1,0,0,2,2,0,0,1},
-    {1,1,1,1,1,1,1,1}
-};
-
-// Mapa actual en uso
-int worldMap[MAP_HEIGHT][MAP_WIDTH];
-int currentLevel = 1;
+// Textura donde se presenta el framebuffer; se sube a la GPU una vez por frame
+Texture2D frameTexture;
 
-struct Player {
-    float x, y;        
-    float angle;       
-    bool hasWon;       
+// Efectos de sonido, en el orden en que se pasan al hilo de audio
+enum GameSound {
+    SOUND_VICTORY
 };
 
-struct Sprite {
-    float x, y;
-    int type; // 0 = cubo azul, 1 = cubo verde, 2 = cubo naranja
-    bool active;
-    float distance; // Para ordenamiento por profundidad
-};
-
-struct Intersect {
-    float distance;
-    char impact;
-};
-
-// Array de sprites en el mundo
-std::vector<Sprite> sprites;
-
-// Buffer de profundidad para sprites (z-buffer)
-float* depthBuffer;
-
-// Audio
-Sound victorySound;
-Music backgroundMusic;
-
-// Configuraciones de sprites para cada nivel
-std::vector<Sprite> level1Sprites = {
-    {BLOCK_SIZE * 2.5f, BLOCK_SIZE * 2.5f, 0, true, 0}, // Cubo azul
-    {BLOCK_SIZE * 5.5f, BLOCK_SIZE * 5.5f, 1, true, 0}, // Cubo verde
-    {BLOCK_SIZE * 1.5f, BLOCK_SIZE * 6.5f, 2, true, 0}, // Cubo naranja
-    {BLOCK_SIZE * 6.5f, BLOCK_SIZE * 2.5f, 0, true, 0}  // Otro cubo azul
-};
-
-std::vector<Sprite> level2Sprites = {
-    {BLOCK_SIZE * 1.5f, BLOCK_SIZE * 1.5f, 1, true, 0}, // Cubo verde
-    {BLOCK_SIZE * 6.5f, BLOCK_SIZE * 1.5f, 2, true, 0}, // Cubo naranja
-    {BLOCK_SIZE * 2.5f, BLOCK_SIZE * 3.5f, 0, true, 0}, // Cubo azul
-    {BLOCK_SIZE * 5.5f, BLOCK_SIZE * 3.5f, 1, true, 0}, // Cubo verde
-    {BLOCK_SIZE * 1.5f, BLOCK_SIZE * 6.5f, 2, true, 0}, // Cubo naranja
-    {BLOCK_SIZE * 6.5f, BLOCK_SIZE * 6.5f, 0, true, 0}  // Cubo azul
-};
-
-void LoadLevel(int levelNumber, Player& player) {
-    currentLevel = levelNumber;
-    
-    if (levelNumber == 1) {
-        // Copiar mapa del nivel 1
-        for (int y = 0; y < MAP_HEIGHT; y++) {
-            for (int x = 0; x < MAP_WIDTH; x++) {
-                worldMap[y][x] = level1Map[y][x];
-            }
-        }
-        sprites = level1Sprites;
-        player.x = BLOCK_SIZE * 1.5f;
-        player.y = BLOCK_SIZE * 1.5f;
-    } else if (levelNumber == 2) {
-        // Copiar mapa del nivel 2
-        for (int y = 0; y < MAP_HEIGHT; y++) {
-            for (int x = 0; x < MAP_WIDTH; x++) {
-                worldMap[y][x] = level2Map[y][x];
-            }
-        }
-        sprites = level2Sprites;
-        player.x = BLOCK_SIZE * 1.5f;
-        player.y = BLOCK_SIZE * 1.5f;
-    }
-    
-    player.angle = 0.0f;
-    player.hasWon = false;
-}
-
-Color* CreateCubeTexture(Color cubeColor) {
-    Color* texture = new Color[SPRITE_SIZE * SPRITE_SIZE];
-    
-    for (int y = 0; y < SPRITE_SIZE; y++) {
-        for (int x = 0; x < SPRITE_SIZE; x++) {
-            // Crear un cubo simple con bordes mas oscuros
-            if (x < 2 || x >= SPRITE_SIZE-2 || y < 2 || y >= SPRITE_SIZE-2) {
-                // Bordes oscuros
-                texture[y * SPRITE_SIZE + x] = {
-                    (unsigned char)(cubeColor.r * 0.3f),
-                    (unsigned char)(cubeColor.g * 0.3f),
-                    (unsigned char)(cubeColor.b * 0.3f),
-                    255
-                };
-            } else if (x < 4 || x >= SPRITE_SIZE-4 || y < 4 || y >= SPRITE_SIZE-4) {
-                // Bordes medios
-                texture[y * SPRITE_SIZE + x] = {
-                    (unsigned char)(cubeColor.r * 0.7f),
-                    (unsigned char)(cubeColor.g * 0.7f),
-                    (unsigned char)(cubeColor.b * 0.7f),
-                    255
-                };
-            } else {
-                // Centro del cubo
-                texture[y * SPRITE_SIZE + x] = cubeColor;
-            }
-        }
-    }
-    
-    return texture;
-}
-
-// Texturas de sprites
-Color* spriteTextures[3];
-
-bool IsWall(float x, float y) {
-    int mapX = (int)x;
-    int mapY = (int)y;
-    
-    if (mapX < 0 || mapX >= MAP_WIDTH || mapY < 0 || mapY >= MAP_HEIGHT) {
-        return true;
-    }
-    
-    return worldMap[mapY][mapX] == 1;
-}
-
-Intersect CastRay(float startX, float startY, float angle, float blockSize, bool drawLine = false) {
-    float d = 0.0f;
-    
-    while (true) {
-        float cosA = d * cosf(angle);
-        float sinA = d * sinf(angle);
-        float x = startX + cosA;
-        float y = startY + sinA;
-        
-        int i = (int)(x / blockSize);
-        int j = (int)(y / blockSize);
-        
-        if (i < 0 || i >= MAP_WIDTH || j < 0 || j >= MAP_HEIGHT) {
-            return {d, '1'};
-        }
-        
-        if (worldMap[j][i] != 0) {
-            if (worldMap[j][i] == 4) {
-                return {d, (char)('0' + worldMap[j][i])};
-            }
-            return {d, (char)('0' + worldMap[j][i])};
-        }
-        
-        if (drawLine) {
-            DrawPixel((int)x * 60 / MAP_WIDTH, (int)y * 60 / MAP_HEIGHT, YELLOW);
-        }
-        
-        d += 5.0f; 
-    }
-}
-
-void DrawSprite(Player& player, Sprite& sprite, Color* texture) {
-    // Calcular vector del jugador al sprite
-    float spriteX = sprite.x - player.x;
-    float spriteY = sprite.y - player.y;
-    
-    // Transformar coordenadas del sprite al espacio de la cámara
-    float invDet = 1.0f / (cosf(player.angle + PI/2) * cosf(player.angle) - sinf(player.angle + PI/2) * sinf(player.angle));
-    float transformX = invDet * (cosf(player.angle) * spriteX - sinf(player.angle) * spriteY);
-    float transformY = invDet * (-sinf(player.angle + PI/2) * spriteX + cosf(player.angle + PI/2) * spriteY);
-    
-    // Si el sprite está detrás del jugador, no dibujarlo
-    if (transformY <= 0) return;
-    
-    // Calcular posición en pantalla
-    int spriteScreenX = (int)((SCREEN_WIDTH / 2) * (1 + transformX / transformY));
-    int spriteHeight = abs((int)(SCREEN_HEIGHT / transformY));
-    int spriteWidth = spriteHeight; 
-    
-    // Calcular límites de dibujo
-    int drawStartY = -spriteHeight / 2 + SCREEN_HEIGHT / 2;
-    if (drawStartY < 0) drawStartY = 0;
-    int drawEndY = spriteHeight / 2 + SCREEN_HEIGHT / 2;
-    if (drawEndY >= SCREEN_HEIGHT) drawEndY = SCREEN_HEIGHT - 1;
-    
-    int drawStartX = -spriteWidth / 2 + spriteScreenX;
-    if (drawStartX < 0) drawStartX = 0;
-    int drawEndX = spriteWidth / 2 + spriteScreenX;
-    if (drawEndX >= SCREEN_WIDTH) drawEndX = SCREEN_WIDTH - 1;
-    
-    for (int stripe = drawStartX; stripe < drawEndX; stripe++) {
-        int texX = (int)(256 * (stripe - (-spriteWidth / 2 + spriteScreenX)) * SPRITE_SIZE / spriteWidth) / 256;
-        
-        // Solo dibujar si el sprite está más cerca que la pared
-        if (transformY < depthBuffer[stripe]) {
-            for (int y = drawStartY; y < drawEndY; y++) {
-                int d = (y) * 256 - SCREEN_HEIGHT * 128 + spriteHeight * 128;
-                int texY = ((d * SPRITE_SIZE) / spriteHeight) / 256;
-                
-                if (texX >= 0 && texX < SPRITE_SIZE && texY >= 0 && texY < SPRITE_SIZE) {
-                    Color color = texture[texY * SPRITE_SIZE + texX];
-                    
-                    // No dibujar pixeles transparentes (negros en este caso)
-                    if (color.r > 10 || color.g > 10 || color.b > 10) {
-                        // Aplicar sombreado por distancia
-                        float brightness = 1.0f / (1 + transformY * 0.01f);
-                        color.r = (unsigned char)(color.r * brightness);
-                        color.g = (unsigned char)(color.g * brightness);
-                        color.b = (unsigned char)(color.b * brightness);
-                        
-                        DrawPixel(stripe, y, color);
-                    }
-                }
-            }
-        }
-    }
-}
+// Capas retenidas de la interfaz (ver ui_layers.h)
+CachedLayer minimapLayer;
+CachedLayer hudLayer;
+CachedLayer menuLayers[2];      // Una por estado del parpadeo de los botones
+CachedLayer victoryLayers[2];
 
-void DrawMenuScreen() {
+// Pantalla de bienvenida con los botones en un estado del parpadeo
+void BuildMenuScreen(bool blink) {
     ClearBackground(DARKPURPLE);
     
     // Pantalla de Bienvenida
@@ -305,10 +85,6 @@ void DrawMenuScreen() {
     int levelWidth = MeasureText(levelText, levelSize);
     DrawText(levelText, (SCREEN_WIDTH - levelWidth) / 2, 360, levelSize, YELLOW);
     
-    static float blinkTimer = 0.0f;
-    blinkTimer += GetFrameTime();
-    bool blink = (int)(blinkTimer * 2) % 2 == 0;
-    
     // Botón Nivel 1
     Color level1Color = blink ? DARKGREEN : GREEN;
     Color level1TextColor = blink ? YELLOW : WHITE;
@@ -345,7 +121,24 @@ void DrawMenuScreen() {
     DrawText(creditText, (SCREEN_WIDTH - creditWidth) / 2, SCREEN_HEIGHT - 30, creditSize, GRAY);
 }
 
-void DrawVictoryScreen(int levelCompleted) {
+// Todo es estatico salvo el parpadeo de los botones: una capa por estado,
+// que se dibuja una sola vez
+void DrawMenuScreen() {
+    static float blinkTimer = 0.0f;
+    blinkTimer += GetFrameTime();
+    bool blink = (int)(blinkTimer * 2) % 2 == 0;
+    
+    CachedLayer& layer = menuLayers[blink ? 1 : 0];
+    if (layer.Stale(SCREEN_WIDTH, SCREEN_HEIGHT, 0)) {
+        layer.Begin(SCREEN_WIDTH, SCREEN_HEIGHT, 0);
+        BuildMenuScreen(blink);
+        layer.End();
+    }
+    layer.Draw(0, 0);
+}
+
+// Pantalla de victoria, con o sin el aviso para volver al menu
+void BuildVictoryScreen(int levelCompleted, bool showMenuHint) {
     ClearBackground(DARKBLUE);
     
     const char* victoryText = "VICTORIA";
@@ -370,10 +163,7 @@ void DrawVictoryScreen(int levelCompleted) {
     int missionWidth = MeasureText(missionText, missionSize);
     DrawText(missionText, (SCREEN_WIDTH - missionWidth) / 2, 250, missionSize, LIGHTGRAY);
     
-    static float blinkTimer = 0.0f;
-    blinkTimer += GetFrameTime();
-    
-    if ((int)(blinkTimer * 2) % 2 == 0) {
+    if (showMenuHint) {
         const char* menuText = "Presiona ENTER para volver al menu";
         int menuSize = 22;
         int menuWidth = MeasureText(menuText, menuSize);
@@ -385,41 +175,257 @@ void DrawVictoryScreen(int levelCompleted) {
     }
 }
 
-int main() {
-    InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Raycaster con Niveles");
-    SetTargetFPS(60);
+// Igual que el menu: una capa por estado del parpadeo, que se rehace si
+// cambia el nivel completado
+void DrawVictoryScreen(int levelCompleted) {
+    static float blinkTimer = 0.0f;
+    blinkTimer += GetFrameTime();
+    bool blink = (int)(blinkTimer * 2) % 2 == 0;
+    
+    CachedLayer& layer = victoryLayers[blink ? 1 : 0];
+    if (layer.Stale(SCREEN_WIDTH, SCREEN_HEIGHT, (uint64_t)levelCompleted)) {
+        layer.Begin(SCREEN_WIDTH, SCREEN_HEIGHT, (uint64_t)levelCompleted);
+        BuildVictoryScreen(levelCompleted, blink);
+        layer.End();
+    }
+    layer.Draw(0, 0);
+}
+
+// Milisegundos desde start
+float MsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Carga el nivel y pasa a jugarlo; si el archivo falta o esta dañado se
+// queda en el menu. Antes espera los assets que se cargan en segundo plano.
+void StartLevel(int levelNumber, Player& player, GameState& gameState, Simulation& simulation,
+                const std::vector<std::shared_future<void>>& assets) {
+    auto start = std::chrono::steady_clock::now();
+    for (const std::shared_future<void>& asset : assets) asset.wait();
+    
+    std::string error;
+    if (LoadLevel(levelNumber, player, &error)) {
+        simulation.Reset(player);
+        gameState = PLAYING;
+        TraceLog(LOG_INFO, "Nivel %d cargado en %.2f ms", levelNumber, MsSince(start));
+    } else {
+        TraceLog(LOG_WARNING, "No se pudo cargar el nivel %d: %s", levelNumber, error.c_str());
+    }
+}
+
+// Manda al cargador el recalculo del PVS de las celdas que cambiaron (ver
+// pvs.h); hasta que termina esas celdas no descartan sprites. Uno a la vez:
+// si el mapa cambio mientras tanto, el resultado se descarta y se lanza otro.
+void StartPvsUpdate(AssetLoader& loader, bool& running) {
+    if (running || !worldPvs.HasPendingCells()) return;
+    running = true;
+    auto update = std::make_shared<PvsUpdate>(worldPvs.StartUpdate(CurrentMapView()));
+    loader.WhenReady(loader.Load([update] { PotentiallyVisibleSet::ComputeUpdate(*update); }), [update, &running] {
+        worldPvs.FinishUpdate(*update);
+        running = false;
+    });
+}
+
+// Color de una celda en el mini-mapa
+Color MinimapCellColor(uint8_t cell) {
+    switch (cell) {
+        case 0: return BLACK;
+        case 1: return WHITE;
+        case 2: return BLUE;
+        case 3: return GREEN;
+        case 4: return PURPLE;
+        default: return GRAY;
+    }
+}
+
+// Mini-mapa con las celdas, los sprites y el jugador. Las celdas y los
+// sprites van en una capa que se rehace solo cuando cambian el mapa, los
+// sprites o la ventana visible (en mapas grandes, MINIMAP_MAX_CELLS celdas
+// alrededor del jugador); el jugador se dibuja encima en cada frame.
+void DrawMinimap(const Player& player) {
+    PROFILE_SCOPE("minimapa");
+    int mapScale = MINIMAP_SIZE;
+    MinimapWindow window = MinimapWindowAround(player.x / BLOCK_SIZE, player.y / BLOCK_SIZE, mapWidth, mapHeight);
+    uint64_t key = LayerKey({sceneVersion, spriteVersion, (uint64_t)window.originX, (uint64_t)window.originY});
+    
+    if (minimapLayer.Stale(mapScale, mapScale, key)) {
+        minimapLayer.Begin(mapScale, mapScale, key);
+        for (int y = 0; y < window.cellsY; y++) {
+            const uint8_t* row = worldMap + (size_t)(window.originY + y) * mapWidth + window.originX;
+            for (int x = 0; x < window.cellsX; x++) {
+                DrawRectangle(x * mapScale/window.cellsX, y * mapScale/window.cellsY, 
+                             mapScale/window.cellsX, mapScale/window.cellsY, MinimapCellColor(row[x]));
+            }
+        }
+        
+        // Sprites dentro de la ventana
+        for (int i = 0; i < sprites.Count(); i++) {
+            if (!sprites.active[i]) continue;
+            float cellX = sprites.x[i] / BLOCK_SIZE - window.originX;
+            float cellY = sprites.y[i] / BLOCK_SIZE - window.originY;
+            if (cellX < 0 || cellY < 0 || cellX >= window.cellsX || cellY >= window.cellsY) continue;
+            Color spriteMapColor;
+            switch (sprites.type[i]) {
+                case 0: spriteMapColor = SKYBLUE; break;
+                case 1: spriteMapColor = LIME; break;
+                default: spriteMapColor = ORANGE; break;
+            }
+            int spriteMapX = cellX * mapScale/window.cellsX;
+            int spriteMapY = cellY * mapScale/window.cellsY;
+            DrawCircle(spriteMapX, spriteMapY, 2, spriteMapColor);
+        }
+        minimapLayer.End();
+    }
+    minimapLayer.Draw(0, 0);
     
-    // Inicializar audio
-    InitAudioDevice();
+    // Dibujar jugador en mini-mapa
+    int playerMapX = (player.x / BLOCK_SIZE - window.originX) * mapScale/window.cellsX;
+    int playerMapY = (player.y / BLOCK_SIZE - window.originY) * mapScale/window.cellsY;
+    DrawCircle(playerMapX, playerMapY, 3, RED);
     
-    // Cargar archivos de audio
-    victorySound = LoadSound("victory.mp3");      
-    backgroundMusic = LoadMusicStream("background.mp3");  
+    int dirX = playerMapX + cosf(player.angle) * 10;
+    int dirY = playerMapY + sinf(player.angle) * 10;
+    DrawLine(playerMapX, playerMapY, dirX, dirY, YELLOW);
+}
+
+// Capa del HUD: la esquina inferior izquierda de la pantalla
+const int HUD_LAYER_WIDTH = 300;
+const int HUD_LAYER_HEIGHT = 120;
+
+// Instrucciones e info del nivel; los textos solo cambian con el nivel y
+// la resolucion de render, asi que se dibujan en una capa
+void DrawHud() {
+    PROFILE_SCOPE("hud");
+    uint64_t key = LayerKey({(uint64_t)currentLevel, (uint64_t)renderWidth, (uint64_t)renderHeight});
+    int top = SCREEN_HEIGHT - HUD_LAYER_HEIGHT;
+    if (hudLayer.Stale(HUD_LAYER_WIDTH, HUD_LAYER_HEIGHT, key)) {
+        hudLayer.Begin(HUD_LAYER_WIDTH, HUD_LAYER_HEIGHT, key);
+        DrawText("WASD: Mover/Girar", 10, SCREEN_HEIGHT - 50 - top, 18, WHITE);
+        DrawText("Encuentra el cubo morado!", 10, SCREEN_HEIGHT - 70 - top, 18, YELLOW);
+        
+        char levelInfo[32];
+        sprintf(levelInfo, "Nivel %d", currentLevel);
+        DrawText(levelInfo, 10, SCREEN_HEIGHT - 90 - top, 18, LIME);
+        
+        if (renderWidth != SCREEN_WIDTH) {
+            char resolutionInfo[32];
+            sprintf(resolutionInfo, "Render %dx%d", renderWidth, renderHeight);
+            DrawText(resolutionInfo, 10, SCREEN_HEIGHT - 110 - top, 18, GRAY);
+        }
+        hudLayer.End();
+    }
+    hudLayer.Draw(0, top);
+}
+
+#ifdef RAYCASTER_PROFILING
+// Panel del perfilador (F3): ms por etapa del ultimo frame y grafica de
+// la duracion de los ultimos frames
+bool showProfiler = false;
+
+void DrawProfilerOverlay() {
+    const int panelX = SCREEN_WIDTH - 290, panelY = 10, panelWidth = 280;
+    ProfileStage stages[PROFILE_MAX_STAGES];
+    int stageCount = ProfileStageTimes(ProfileCurrentFrame() - 1, stages, PROFILE_MAX_STAGES);
+    int graphHeight = 60;
+    int panelHeight = 30 + stageCount * 16 + graphHeight + 10;
+    DrawRectangle(panelX, panelY, panelWidth, panelHeight, Fade(BLACK, 0.75f));
+    
+    int historyCount = ProfileHistoryCount();
+    char line[96];
+    sprintf(line, "Frame: %.2f ms", historyCount > 0 ? ProfileFrameMs(0) : 0.0f);
+    DrawText(line, panelX + 8, panelY + 6, 16, WHITE);
+    for (int i = 0; i < stageCount; i++) {
+        sprintf(line, "%-24s %6.2f ms", stages[i].name, stages[i].ms);
+        DrawText(line, panelX + 8, panelY + 28 + i * 16, 12, LIGHTGRAY);
+    }
     
-    // Configurar musica de fondo si se cargo correctamente
-    if (backgroundMusic.stream.buffer != NULL) {
-        SetMusicVolume(backgroundMusic, 0.5f);
-        PlayMusicStream(backgroundMusic);
-    } else {
-        TraceLog(LOG_WARNING, "No se pudo cargar background.mp3");
+    // Una barra por frame, la mas reciente a la derecha; la linea marca 16.7 ms
+    int graphY = panelY + 30 + stageCount * 16;
+    const float maxMs = 33.3f;
+    int bars = std::min(historyCount, panelWidth - 16);
+    for (int age = 0; age < bars; age++) {
+        float ms = ProfileFrameMs(age);
+        int height = (int)(std::min(ms, maxMs) / maxMs * graphHeight);
+        Color color = ms > 16.7f ? RED : LIME;
+        DrawLine(panelX + panelWidth - 8 - age, graphY + graphHeight, panelX + panelWidth - 8 - age, graphY + graphHeight - height, color);
+    }
+    int targetY = graphY + graphHeight - (int)(16.7f / maxMs * graphHeight);
+    DrawLine(panelX + 8, targetY, panelX + panelWidth - 8, targetY, YELLOW);
+}
+#endif
+
+int main(int argc, char** argv) {
+    auto programStart = std::chrono::steady_clock::now();
+    InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Raycaster con Niveles");
+    SetTargetFPS(ParseTargetFps(argc, argv));
+    
+    // Paquete de assets (ver asset_bundle.h); sin el se usan los archivos sueltos
+    std::string bundleError;
+    if (!assetBundle.Open(ASSET_BUNDLE_FILE, &bundleError)) {
+        TraceLog(LOG_INFO, "Sin paquete de assets (%s), se usan archivos sueltos", bundleError.c_str());
     }
     
+    // Audio en su propio hilo (ver audio.h); la musica de fondo arranca
+    // apenas termina de cargar
+    AudioThread audio({"victory.mp3"}, "background.mp3", &assetBundle);
+    audio.SetMusicVolume(0.5f);
+    audio.PlayMusic();
+    
     // Inicializar buffer de profundidad
     depthBuffer = new float[SCREEN_WIDTH];
     
-    // Crear texturas de sprites
-    spriteTextures[0] = CreateCubeTexture(SKYBLUE);   // Cubo azul
-    spriteTextures[1] = CreateCubeTexture(LIME);      // Cubo verde
-    spriteTextures[2] = CreateCubeTexture(ORANGE);    // Cubo naranja
+    // Inicializar framebuffer y la textura donde se presenta
+    frameBuffer = new Color[SCREEN_WIDTH * SCREEN_HEIGHT];
+    Image frameImage = GenImageColor(SCREEN_WIDTH, SCREEN_HEIGHT, BLACK);
+    frameTexture = LoadTextureFromImage(frameImage);
+    UnloadImage(frameImage);
+    
+    // Con resolucion dinamica la vista se escala a la ventana con filtro bilineal
+    float targetMs = ParseTargetFrameMs(argc, argv);
+    ResolutionController resolution(targetMs);
+    if (targetMs > 0) SetTextureFilter(frameTexture, TEXTURE_FILTER_BILINEAR);
+    
+    // Pool de hilos para el renderizador por columnas
+    renderPool = new ThreadPool(ParseThreadCount(argc, argv));
+    rayKernel = ParseRayKernel(argc, argv);
+    
+    // Las texturas de sprites y paredes se arman en segundo plano mientras
+    // se muestra el menu; StartLevel las espera
+    AssetLoader loader(renderPool->ThreadCount());
+    std::vector<std::shared_future<void>> textureLoads = {loader.Load(CreateSpriteTextures), loader.Load(CreateWallTextures)};
+    int texturesPending = (int)textureLoads.size();
+    for (const std::shared_future<void>& load : textureLoads) {
+        loader.WhenReady(load, [&texturesPending, programStart] {
+            if (--texturesPending == 0) TraceLog(LOG_INFO, "Texturas listas a los %.1f ms", MsSince(programStart));
+        });
+    }
+    loader.WhenReady(audio.Ready(), [programStart] { TraceLog(LOG_INFO, "Audio listo a los %.1f ms", MsSince(programStart)); });
     
+    // player es la pose que se dibuja; la del juego vive en la simulacion
     Player player = {BLOCK_SIZE * 4, BLOCK_SIZE * 4, 0.0f, false};
     GameState gameState = MENU;
+    Simulation simulation;
+    bool firstFrame = true;
+    bool pvsUpdateRunning = false;
+    
+    // Con --record cada partida se graba para repetirla (ver replay.h)
+    const char* recordPath = ParseRecordPath(argc, argv);
+    InputRecorder recorder;
     
     while (!WindowShouldClose()) {
-        // Actualizar música de fondo
-        if (backgroundMusic.stream.buffer != NULL) {
-            UpdateMusicStream(backgroundMusic);
+        PROFILE_FRAME();
+        auto frameStart = std::chrono::steady_clock::now();
+        loader.Poll();
+        
+#ifdef RAYCASTER_PROFILING
+        // F3 muestra u oculta el perfilador; F4 exporta los ultimos frames
+        if (IsKeyPressed(KEY_F3)) showProfiler = !showProfiler;
+        if (IsKeyPressed(KEY_F4)) {
+            simulation.Wait();
+            bool ok = ProfileWriteChromeTrace("profile_trace.json") && ProfileWriteCsv("profile.csv");
+            TraceLog(ok ? LOG_INFO : LOG_WARNING, ok ? "Perfil exportado a profile_trace.json y profile.csv" : "No se pudo exportar el perfil");
         }
+#endif
         
         BeginDrawing();
         
@@ -429,13 +435,12 @@ int main() {
                 
                 // Selección de nivel
                 if (IsKeyPressed(KEY_ONE)) {
-                    LoadLevel(1, player);
-                    gameState = PLAYING;
+                    StartLevel(1, player, gameState, simulation, textureLoads);
                 }
                 if (IsKeyPressed(KEY_TWO)) {
-                    LoadLevel(2, player);
-                    gameState = PLAYING;
+                    StartLevel(2, player, gameState, simulation, textureLoads);
                 }
+                if (gameState == PLAYING && recordPath != NULL) recorder.Begin(currentLevel, player);
                 
                 if (IsKeyPressed(KEY_ESCAPE)) {
                     CloseWindow();
@@ -445,160 +450,51 @@ int main() {
                 
             case PLAYING: {
                 // Bloque para evitar problemas con variables declaradas en switch
-                if (!player.hasWon) {
-                    float moveSpeed = 3.0f;
-                    if (IsKeyDown(KEY_W)) {
-                        float newX = player.x + cosf(player.angle) * moveSpeed;
-                        float newY = player.y + sinf(player.angle) * moveSpeed;
-                        int mapX = (int)(newX / BLOCK_SIZE);
-                        int mapY = (int)(newY / BLOCK_SIZE);
-                        if (mapX >= 0 && mapX < MAP_WIDTH && mapY >= 0 && mapY < MAP_HEIGHT) {
-                            if (worldMap[mapY][mapX] == 4) {
-                                worldMap[mapY][mapX] = 0;
-                                player.hasWon = true;
-                                gameState = VICTORY;
-                                
-                                // Reproducir sonido de victoria
-                                if (victorySound.stream.buffer != NULL) {
-                                    PlaySound(victorySound);
-                                }
-                            }
-                            if (worldMap[mapY][mapX] == 0) {
-                                player.x = newX;
-                                player.y = newY;
-                            }
-                        }
-                    }
-                    if (IsKeyDown(KEY_S)) {
-                        float newX = player.x - cosf(player.angle) * moveSpeed;
-                        float newY = player.y - sinf(player.angle) * moveSpeed;
-                        int mapX = (int)(newX / BLOCK_SIZE);
-                        int mapY = (int)(newY / BLOCK_SIZE);
-                        if (mapX >= 0 && mapX < MAP_WIDTH && mapY >= 0 && mapY < MAP_HEIGHT) {
-                            if (worldMap[mapY][mapX] == 4) {
-                                worldMap[mapY][mapX] = 0;
-                                player.hasWon = true;
-                                gameState = VICTORY;
-                                
-                                // Reproducir sonido de victoria
-                                if (victorySound.stream.buffer != NULL) {
-                                    PlaySound(victorySound);
-                                }
-                            }
-                            if (worldMap[mapY][mapX] == 0) {
-                                player.x = newX;
-                                player.y = newY;
-                            }
-                        }
-                    }
-                    if (IsKeyDown(KEY_A)) player.angle -= 0.05f;
-                    if (IsKeyDown(KEY_D)) player.angle += 0.05f;
+                PlayerInput input;
+                {
+                    PROFILE_SCOPE("entrada");
+                    input = {IsKeyDown(KEY_W), IsKeyDown(KEY_S), IsKeyDown(KEY_A), IsKeyDown(KEY_D)};
                 }
                 
-                ClearBackground(BLACK);
-                
-                // Renderizar vista 3D y llenar buffer de profundidad
-                for (int x = 0; x < NUM_RAYS; x++) {
-                    float rayAngle = player.angle - FOV/2 + (FOV * x / NUM_RAYS);
-                    
-                    Intersect hit = CastRay(player.x, player.y, rayAngle, BLOCK_SIZE, false);
-                    float correctedDistance = hit.distance * cosf(rayAngle - player.angle);
-                    
-                    // Guardar distancia en buffer de profundidad
-                    depthBuffer[x] = correctedDistance;
-                    
-                    float wallHeight = (SCREEN_HEIGHT / correctedDistance) * BLOCK_SIZE;
-                    
-                    int wallTop = (SCREEN_HEIGHT - wallHeight) / 2;
-                    int wallBottom = wallTop + wallHeight;
-                    
-                    Color wallColor;
-                    switch (hit.impact) {
-                        case '1': wallColor = RED; break;
-                        case '2': wallColor = BLUE; break;
-                        case '3': wallColor = GREEN; break;
-                        case '4': wallColor = PURPLE; break;
-                        default: wallColor = WHITE; break;
+                // Resultado de los ticks lanzados en el frame anterior: aplicar
+                // sus cambios al mapa (con la simulacion quieta) y tomar la pose
+                const SimSnapshot& snapshot = simulation.Wait();
+                for (const CellEdit& edit : snapshot.edits) SetMapCell(edit.x, edit.y, edit.value);
+                StartPvsUpdate(loader, pvsUpdateRunning);
+                player = snapshot.Interpolated();
+                recorder.Record(snapshot);
+                if (snapshot.won) {
+                    gameState = VICTORY;
+                    if (recorder.IsRecording() && !recorder.Finish(snapshot.current, recordPath)) {
+                        TraceLog(LOG_WARNING, "No se pudo guardar la grabacion en %s", recordPath);
                     }
                     
-                    int brightness = (int)(255 / (1 + correctedDistance * 0.01f));
-                    wallColor.r = (wallColor.r * brightness) / 255;
-                    wallColor.g = (wallColor.g * brightness) / 255;
-                    wallColor.b = (wallColor.b * brightness) / 255;
-                    
-                    DrawLine(x, wallTop, x, wallBottom, wallColor);
-                }
-                
-                // Calcular distancias de sprites y ordenar por profundidad
-                for (auto& sprite : sprites) {
-                    if (sprite.active) {
-                        float dx = sprite.x - player.x;
-                        float dy = sprite.y - player.y;
-                        sprite.distance = dx * dx + dy * dy;
-                    }
+                    // Reproducir sonido de victoria
+                    audio.Play(SOUND_VICTORY);
+                } else {
+                    // Los ticks del frame siguiente corren mientras se dibuja este
+                    simulation.Start(input, GetFrameTime());
                 }
                 
-                // Ordenar sprites por distancia (más lejanos primero)
-                std::sort(sprites.begin(), sprites.end(), [](const Sprite& a, const Sprite& b) {
-                    return a.distance > b.distance;
-                });
-                
-                // Dibujar sprites
-                for (auto& sprite : sprites) {
-                    if (sprite.active) {
-                        DrawSprite(player, sprite, spriteTextures[sprite.type]);
-                    }
-                }
+                ClearBackground(BLACK);
                 
-                // Dibujar mini-mapa
-                int mapScale = 60;
-                for (int y = 0; y < MAP_HEIGHT; y++) {
-                    for (int x = 0; x < MAP_WIDTH; x++) {
-                        Color color;
-                        switch (worldMap[y][x]) {
-                            case 0: color = BLACK; break;
-                            case 1: color = WHITE; break;
-                            case 2: color = BLUE; break;
-                            case 3: color = GREEN; break;
-                            case 4: color = PURPLE; break;
-                            default: color = GRAY; break;
-                        }
-                        DrawRectangle(x * mapScale/MAP_WIDTH, y * mapScale/MAP_HEIGHT, 
-                                     mapScale/MAP_WIDTH, mapScale/MAP_HEIGHT, color);
-                    }
+                // Renderizar vista 3D en el framebuffer (si nada cambio queda el anterior)
+                bool redrawn;
+                {
+                    PROFILE_SCOPE("escena 3D");
+                    redrawn = RenderScene(player, CurrentMapView());
                 }
                 
-                // Dibujar sprites en mini-mapa
-                for (const auto& sprite : sprites) {
-                    if (sprite.active) {
-                        Color spriteMapColor;
-                        switch (sprite.type) {
-                            case 0: spriteMapColor = SKYBLUE; break;
-                            case 1: spriteMapColor = LIME; break;
-                            case 2: spriteMapColor = ORANGE; break;
-                        }
-                        int spriteMapX = (sprite.x / BLOCK_SIZE) * mapScale/MAP_WIDTH;
-                        int spriteMapY = (sprite.y / BLOCK_SIZE) * mapScale/MAP_HEIGHT;
-                        DrawCircle(spriteMapX, spriteMapY, 2, spriteMapColor);
-                    }
+                // Subir el framebuffer con una sola textura y estirarlo a la ventana
+                {
+                    PROFILE_SCOPE("subir framebuffer");
+                    Rectangle source = {0, 0, (float)renderWidth, (float)renderHeight};
+                    if (redrawn) UpdateTextureRec(frameTexture, source, frameBuffer);
+                    DrawTexturePro(frameTexture, source, {0, 0, (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT}, {0, 0}, 0.0f, WHITE);
                 }
                 
-                // Dibujar jugador en mini-mapa
-                int playerMapX = (player.x / BLOCK_SIZE) * mapScale/MAP_WIDTH;
-                int playerMapY = (player.y / BLOCK_SIZE) * mapScale/MAP_HEIGHT;
-                DrawCircle(playerMapX, playerMapY, 3, RED);
-                
-                int dirX = playerMapX + cosf(player.angle) * 10;
-                int dirY = playerMapY + sinf(player.angle) * 10;
-                DrawLine(playerMapX, playerMapY, dirX, dirY, YELLOW);
-                
-                // Instrucciones y info del nivel
-                DrawText("WASD: Mover/Girar", 10, SCREEN_HEIGHT - 50, 18, WHITE);
-                DrawText("Encuentra el cubo morado!", 10, SCREEN_HEIGHT - 70, 18, YELLOW);
-                
-                char levelInfo[32];
-                sprintf(levelInfo, "Nivel %d", currentLevel);
-                DrawText(levelInfo, 10, SCREEN_HEIGHT - 90, 18, LIME);
+                DrawMinimap(player);
+                DrawHud();
                 break;
             } // Fin del bloque PLAYING
                 
@@ -612,23 +508,48 @@ int main() {
             } // Fin del bloque VICTORY
         }
         
-        EndDrawing();
+#ifdef RAYCASTER_PROFILING
+        // El hilo de simulacion escribe en su propio buffer de eventos:
+        // esperar a que termine antes de leerlos
+        if (showProfiler) {
+            simulation.Wait();
+            DrawProfilerOverlay();
+        }
+#endif
+        
+        // Ajustar la resolucion con el tiempo de trabajo del frame (la
+        // espera de vsync en EndDrawing no cuenta)
+        if (targetMs > 0 && gameState == PLAYING) {
+            float workMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+            if (resolution.Update(workMs)) SetRenderResolution(resolution.Scale());
+        }
+        
+        {
+            PROFILE_SCOPE("presentar");
+            EndDrawing();
+        }
+        if (firstFrame) {
+            TraceLog(LOG_INFO, "Primer frame a los %.1f ms", MsSince(programStart));
+            firstFrame = false;
+        }
     }
     
-    // Limpiar memoria y audio
-    if (backgroundMusic.stream.buffer != NULL) {
-        UnloadMusicStream(backgroundMusic);
-    }
-    if (victorySound.stream.buffer != NULL) {
-        UnloadSound(victorySound);
+    // Una partida a medias tambien se guarda, con los ticks del ultimo frame
+    if (recorder.IsRecording()) {
+        const SimSnapshot& last = simulation.Wait();
+        recorder.Record(last);
+        if (!recorder.Finish(last.current, recordPath)) TraceLog(LOG_WARNING, "No se pudo guardar la grabacion en %s", recordPath);
     }
     
-    CloseAudioDevice();
-    
+    // Limpiar memoria (el audio se cierra al destruir su hilo)
     delete[] depthBuffer;
-    for (int i = 0; i < 3; i++) {
-        delete[] spriteTextures[i];
-    }
+    delete[] frameBuffer;
+    delete renderPool;
+    UnloadTexture(frameTexture);
+    minimapLayer.Unload();
+    hudLayer.Unload();
+    for (CachedLayer& layer : menuLayers) layer.Unload();
+    for (CachedLayer& layer : victoryLayers) layer.Unload();
     
     CloseWindow();
     return 0;
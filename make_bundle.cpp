@@ -0,0 +1,65 @@
+// Arma el paquete de assets del juego (assets.pak, ver asset_bundle.h): las
+// texturas de cubo ya generadas, el audio y los niveles levels/level<N>.lvl
+// (desde el 1 hasta el primero que falte).
+//
+// Uso: make_bundle [salida] [directorio]   (por defecto "assets.pak" y ".")
+
+#include "raycaster.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Contenido completo de un archivo; false si no se pudo leer
+bool ReadWholeFile(const std::string& path, std::vector<unsigned char>& data) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == NULL) return false;
+    data.clear();
+    unsigned char buffer[1 << 16];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) data.insert(data.end(), buffer, buffer + count);
+    bool ok = ferror(file) == 0;
+    fclose(file);
+    return ok;
+}
+
+void AddTexture(std::vector<BundleSource>& sources, const CubeTextureInfo& info) {
+    Color* texture = CreateCubeTexture(info.color);
+    sources.push_back({info.name, BUNDLE_TEXTURE, BundleTextureData(texture, SPRITE_SIZE)});
+    delete[] texture;
+}
+
+int main(int argc, char** argv) {
+    std::string output = argc > 1 ? argv[1] : ASSET_BUNDLE_FILE;
+    std::string dir = argc > 2 ? argv[2] : ".";
+
+    std::vector<BundleSource> sources;
+    for (const CubeTextureInfo& info : WALL_TEXTURES) AddTexture(sources, info);
+    AddTexture(sources, FLOOR_TEXTURE);
+    AddTexture(sources, CEILING_TEXTURE);
+    for (const CubeTextureInfo& info : SPRITE_TEXTURES) AddTexture(sources, info);
+
+    const char* audioFiles[] = {"victory.mp3", "background.mp3"};
+    for (const char* name : audioFiles) {
+        BundleSource source = {name, BUNDLE_AUDIO, {}};
+        if (!ReadWholeFile(dir + "/" + name, source.data)) {
+            fprintf(stderr, "No se pudo leer %s/%s\n", dir.c_str(), name);
+            return 1;
+        }
+        sources.push_back(std::move(source));
+    }
+
+    int levels = 0;
+    for (int n = 1;; n++) {
+        BundleSource source = {LevelPath(n), BUNDLE_LEVEL, {}};
+        if (!ReadWholeFile(dir + "/" + source.name, source.data)) break;
+        sources.push_back(std::move(source));
+        levels++;
+    }
+
+    if (!WriteAssetBundle(output.c_str(), sources)) {
+        fprintf(stderr, "No se pudo escribir %s\n", output.c_str());
+        return 1;
+    }
+    printf("%s: %d entradas (%d niveles)\n", output.c_str(), (int)sources.size(), levels);
+    return 0;
+}
@@ -0,0 +1,79 @@
+// Genera los archivos de nivel (levels/*.lvl) a partir de los mapas del juego.
+//
+// Uso: make_levels [directorio]   (por defecto "levels")
+
+#include "level_format.h"
+#include <string>
+
+// Mapas de los niveles
+uint8_t level1Map[8][8] = {
+    {1,1,1,1,1,1,1,1},
+    {1,0,0,0,0,0,0,1},
+    {1,0,2,0,0,3,0,1},
+    {1,0,0,0,4,0,0,1}, // 4 = cubo morado (objetivo)
+    {1,0,2,0,0,3,0,1},
+    {1,0,0,0,0,0,0,1},
+    {1,0,0,0,0,0,0,1},
+    {1,1,1,1,1,1,1,1}
+};
+
+uint8_t level2Map[8][8] = {
+    {1,1,1,1,1,1,1,1},
+    {1,0,0,2,2,0,0,1},
+    {1,0,0,0,0,3,0,1},
+    {1,2,3,0,0,0,2,1},
+    {1,0,0,0,4,0,0,1}, // 4 = cubo morado (objetivo)
+    {1,2,0,3,0,3,0,1},
+    {1,0,0,2,2,0,0,1},
+    {1,1,1,1,1,1,1,1}
+};
+
+// Sprites de cada nivel en coordenadas de celda
+// (tipo 0 = cubo azul, 1 = cubo verde, 2 = cubo naranja)
+LevelSprite level1Sprites[] = {
+    {2.5f, 2.5f, 0}, // Cubo azul
+    {5.5f, 5.5f, 1}, // Cubo verde
+    {1.5f, 6.5f, 2}, // Cubo naranja
+    {6.5f, 2.5f, 0}  // Otro cubo azul
+};
+
+LevelSprite level2Sprites[] = {
+    {1.5f, 1.5f, 1}, // Cubo verde
+    {6.5f, 1.5f, 2}, // Cubo naranja
+    {2.5f, 3.5f, 0}, // Cubo azul
+    {5.5f, 3.5f, 1}, // Cubo verde
+    {1.5f, 6.5f, 2}, // Cubo naranja
+    {6.5f, 6.5f, 0}  // Cubo azul
+};
+
+// Luces de cada nivel en coordenadas de celda (ver lighting.h): x, y,
+// radio en celdas e intensidad. El resto del mapa queda con la luz ambiente.
+const uint32_t LEVEL_AMBIENT_LIGHT = 110;
+
+LevelLight level1Lights[] = {
+    {1.5f, 1.5f, 5.0f, 150},  // Esquina de inicio
+    {6.5f, 6.5f, 5.0f, 150},  // Esquina opuesta
+    {4.5f, 4.5f, 3.0f, 120}   // Junto al objetivo
+};
+
+LevelLight level2Lights[] = {
+    {1.5f, 1.5f, 5.0f, 150},  // Esquina de inicio
+    {6.5f, 6.5f, 5.0f, 150},  // Esquina opuesta
+    {4.5f, 3.5f, 3.0f, 120}   // Junto al objetivo
+};
+
+int main(int argc, char** argv) {
+    std::string dir = argc > 1 ? argv[1] : "levels";
+    
+    bool ok = WriteLevelFile((dir + "/level1.lvl").c_str(), 8, 8, &level1Map[0][0],
+                             level1Sprites, sizeof(level1Sprites) / sizeof(LevelSprite), 1.5f, 1.5f, 0.0f,
+                             level1Lights, sizeof(level1Lights) / sizeof(LevelLight), LEVEL_AMBIENT_LIGHT, true) &&
+              WriteLevelFile((dir + "/level2.lvl").c_str(), 8, 8, &level2Map[0][0],
+                             level2Sprites, sizeof(level2Sprites) / sizeof(LevelSprite), 1.5f, 1.5f, 0.0f,
+                             level2Lights, sizeof(level2Lights) / sizeof(LevelLight), LEVEL_AMBIENT_LIGHT, true);
+    if (!ok) {
+        fprintf(stderr, "No se pudieron escribir los niveles en %s\n", dir.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+
+#if defined(_WIN32)
+// Evitar choques de nombres con raylib (CloseWindow, DrawText, PlaySound, Rectangle...)
+#define NOGDI
+#define NOUSER
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Archivo mapeado en memoria en modo copia-al-escribir: se puede modificar
+// el contenido en memoria (por ejemplo, quitar el cubo objetivo del mapa)
+// sin tocar el archivo en disco. Abrir no lee el archivo; las paginas se
+// cargan cuando se usan, asi que el costo no depende del tamaño.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept { *this = static_cast<MappedFile&&>(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            Close();
+            data = other.data;
+            size = other.size;
+#if defined(_WIN32)
+            mapping = other.mapping;
+            other.mapping = NULL;
+#endif
+            other.data = nullptr;
+            other.size = 0;
+        }
+        return *this;
+    }
+
+    bool Open(const char* path) {
+        Close();
+#if defined(_WIN32)
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+            CloseHandle(file);
+            return false;
+        }
+        mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+        CloseHandle(file);
+        if (mapping == NULL) return false;
+        data = (unsigned char*)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+        if (data == nullptr) {
+            CloseHandle(mapping);
+            mapping = NULL;
+            return false;
+        }
+        size = (size_t)fileSize.QuadPart;
+#else
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) return false;
+        data = (unsigned char*)mapped;
+        size = (size_t)info.st_size;
+#endif
+        return true;
+    }
+
+    void Close() {
+        if (data == nullptr) return;
+#if defined(_WIN32)
+        UnmapViewOfFile(data);
+        CloseHandle(mapping);
+        mapping = NULL;
+#else
+        munmap(data, size);
+#endif
+        data = nullptr;
+        size = 0;
+    }
+
+    bool IsOpen() const { return data != nullptr; }
+    unsigned char* Data() const { return data; }
+    size_t Size() const { return size; }
+
+private:
+    unsigned char* data = nullptr;
+    size_t size = 0;
+#if defined(_WIN32)
+    HANDLE mapping = NULL;
+#endif
+};
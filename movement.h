@@ -0,0 +1,264 @@
+#pragma once
+
+// Movimiento con colision contra la grilla del mapa.
+//
+// Todo lo que se mueve es un circulo (en coordenadas de celda) que no puede
+// entrar en las celdas ocupadas; fuera del mapa cuenta como ocupado. El
+// movimiento de un tick se barre en pasos de a lo sumo el radio, asi que
+// ninguna velocidad atraviesa una pared de una celda, y despues de cada
+// paso el circulo se empuja fuera de las celdas que toca por la normal del
+// contacto: lo que queda del paso sigue a lo largo de la pared (desliza).
+//
+// Antes de todo eso se prueba el caso comun sin contacto: si las celdas
+// del rectangulo barrido estan vacias el paso se aplica directo. Para pasos
+// largos en zonas abiertas basta una lectura del campo de espacio vacio de
+// los rayos (ver empty_space.h): si el cuadro libre alrededor de la celda
+// contiene el barrido no hace falta revisar celda por celda. Con y sin
+// campo la posicion final es exactamente la misma.
+//
+// Tocar una celda objetivo (4) no la atraviesa: se reporta en el resultado
+// para que quien mueve decida que hacer (el jugador gana el nivel).
+//
+// MovingEntities mueve muchas entidades por tick en estructura de arreglos:
+// una pasada sin ramas sobre los arreglos hace la prueba rapida de todas y
+// solo las que quedan contra una pared pasan por el barrido. Los bloques de
+// entidades se reparten entre los hilos del pool.
+
+#include "raycast.h"
+#include "sprites.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+const uint8_t GOAL_CELL = 4;
+const float PLAYER_RADIUS = 0.2f;       // En celdas
+const int ENTITY_TASK_SIZE = 1024;      // Entidades por tarea del pool
+
+struct MoveResult {
+    bool blocked = false;           // Alguna pared freno o desvio el movimiento
+    float normalX = 0, normalY = 0; // Normal media de los contactos (unitaria si blocked)
+    int goalX = -1, goalY = -1;     // Celda objetivo que toco, o -1
+};
+
+inline bool SolidCell(const MapView& map, int x, int y) {
+    return x < 0 || y < 0 || x >= map.width || y >= map.height || map.cells[y * map.width + x] != 0;
+}
+
+// Las celdas que toca el rectangulo [x0, x1] x [y0, y1] estan todas vacias
+inline bool AreaFree(const MapView& map, float x0, float y0, float x1, float y1) {
+    int cx0 = (int)floorf(x0), cy0 = (int)floorf(y0);
+    int cx1 = (int)floorf(x1), cy1 = (int)floorf(y1);
+    for (int cy = cy0; cy <= cy1; cy++) {
+        for (int cx = cx0; cx <= cx1; cx++) {
+            if (SolidCell(map, cx, cy)) return false;
+        }
+    }
+    return true;
+}
+
+// Prueba rapida con el campo de espacio vacio: el barrido del circulo de
+// (x, y) a (x + dx, y + dy) cabe en el cuadro libre de la celda de (x, y)
+inline bool SweepInEmptySquare(const MapView& map, float x, float y, float radius, float dx, float dy) {
+    int cx = (int)floorf(x), cy = (int)floorf(y);
+    if (cx < 0 || cy < 0 || cx >= map.width || cy >= map.height) return false;
+    int k = map.emptySpace[cy * map.width + cx];
+    float lowX = (float)(cx - k + 1), highX = (float)(cx + k);
+    float lowY = (float)(cy - k + 1), highY = (float)(cy + k);
+    return std::min(x, x + dx) - radius >= lowX && std::max(x, x + dx) + radius < highX &&
+           std::min(y, y + dy) - radius >= lowY && std::max(y, y + dy) + radius < highY;
+}
+
+// Empuja el circulo fuera de las celdas ocupadas que toca y acumula los
+// contactos en result
+inline void PushOutOfWalls(const MapView& map, float& x, float& y, float radius, MoveResult& result) {
+    int cx0 = (int)floorf(x - radius), cy0 = (int)floorf(y - radius);
+    int cx1 = (int)floorf(x + radius), cy1 = (int)floorf(y + radius);
+    for (int cy = cy0; cy <= cy1; cy++) {
+        for (int cx = cx0; cx <= cx1; cx++) {
+            if (!SolidCell(map, cx, cy)) continue;
+            // Punto de la celda mas cercano al centro
+            float nearestX = std::clamp(x, (float)cx, (float)(cx + 1));
+            float nearestY = std::clamp(y, (float)cy, (float)(cy + 1));
+            float offsetX = x - nearestX, offsetY = y - nearestY;
+            float distance2 = offsetX * offsetX + offsetY * offsetY;
+            if (distance2 >= radius * radius) continue;
+
+            float normalX, normalY, depth;
+            if (distance2 > 0) {
+                float distance = sqrtf(distance2);
+                normalX = offsetX / distance;
+                normalY = offsetY / distance;
+                depth = radius - distance;
+            } else {
+                // Centro dentro de la celda (solo si empezo adentro): salir
+                // por el lado mas cercano
+                float left = x - cx, right = cx + 1 - x, top = y - cy, bottom = cy + 1 - y;
+                float nearest = std::min({left, right, top, bottom});
+                normalX = nearest == left ? -1.0f : nearest == right ? 1.0f : 0.0f;
+                normalY = normalX != 0 ? 0.0f : nearest == top ? -1.0f : 1.0f;
+                depth = nearest + radius;
+            }
+            x += normalX * depth;
+            y += normalY * depth;
+            result.blocked = true;
+            result.normalX += normalX;
+            result.normalY += normalY;
+            bool inside = cx >= 0 && cy >= 0 && cx < map.width && cy < map.height;
+            if (inside && map.cells[cy * map.width + cx] == GOAL_CELL && result.goalX < 0) {
+                result.goalX = cx;
+                result.goalY = cy;
+            }
+        }
+    }
+}
+
+// Mueve el circulo de centro (x, y) en (dx, dy) contra las paredes de map
+inline MoveResult MoveCircle(const MapView& map, float& x, float& y, float radius, float dx, float dy) {
+    MoveResult result;
+    bool free = map.emptySpace != nullptr && SweepInEmptySquare(map, x, y, radius, dx, dy);
+    if (!free) {
+        free = AreaFree(map, std::min(x, x + dx) - radius, std::min(y, y + dy) - radius,
+                        std::max(x, x + dx) + radius, std::max(y, y + dy) + radius);
+    }
+    if (free) {
+        x += dx;
+        y += dy;
+        return result;
+    }
+
+    int steps = std::max(1, (int)ceilf(sqrtf(dx * dx + dy * dy) / radius));
+    float stepX = dx / steps, stepY = dy / steps;
+    for (int s = 0; s < steps; s++) {
+        x += stepX;
+        y += stepY;
+        PushOutOfWalls(map, x, y, radius, result);
+    }
+    if (result.blocked) {
+        float length = sqrtf(result.normalX * result.normalX + result.normalY * result.normalY);
+        if (length > 0) {
+            result.normalX /= length;
+            result.normalY /= length;
+        }
+    }
+    return result;
+}
+
+// Una entidad toco una celda objetivo en este tick
+struct EntityTrigger {
+    int entity;
+    int cellX, cellY;
+};
+
+// Entidades que se mueven solas, en estructura de arreglos y coordenadas de
+// celda. Rebotan contra las paredes; cada una puede mover un sprite.
+class MovingEntities {
+public:
+    std::vector<float> x, y;
+    std::vector<float> velX, velY;  // Celdas por tick
+    std::vector<int> sprite;        // Indice en el SpriteSet, o -1
+    float radius = 0.25f;
+
+    int Count() const { return (int)x.size(); }
+
+    void Clear() {
+        x.clear();
+        y.clear();
+        velX.clear();
+        velY.clear();
+        sprite.clear();
+        triggers.clear();
+    }
+
+    // (entityX, entityY) tiene que estar en una celda vacia
+    int Add(float entityX, float entityY, float entityVelX, float entityVelY, int spriteIndex = -1) {
+        x.push_back(entityX);
+        y.push_back(entityY);
+        velX.push_back(entityVelX);
+        velY.push_back(entityVelY);
+        sprite.push_back(spriteIndex);
+        return Count() - 1;
+    }
+
+    // Un tick de todas las entidades. El resultado no depende de cuantos
+    // hilos tenga pool (puede ser nullptr) ni de si map trae el campo de
+    // espacio vacio.
+    void Step(const MapView& map, ThreadPool* pool) {
+        int numTasks = (Count() + ENTITY_TASK_SIZE - 1) / ENTITY_TASK_SIZE;
+        if (taskTriggers.size() < (size_t)numTasks) taskTriggers.resize(numTasks);
+        if (nearWall.size() < x.size()) nearWall.resize(x.size());
+        auto task = [&](int t) {
+            int begin = t * ENTITY_TASK_SIZE;
+            int end = std::min(begin + ENTITY_TASK_SIZE, Count());
+            taskTriggers[t].clear();
+            StepRange(map, begin, end, taskTriggers[t]);
+        };
+        if (pool != nullptr && numTasks > 1) {
+            pool->ParallelFor(numTasks, task);
+        } else {
+            for (int t = 0; t < numTasks; t++) task(t);
+        }
+
+        triggers.clear();
+        for (int t = 0; t < numTasks; t++) triggers.insert(triggers.end(), taskTriggers[t].begin(), taskTriggers[t].end());
+    }
+
+    // Entidades que tocaron una celda objetivo en el ultimo Step, por indice
+    const std::vector<EntityTrigger>& Triggers() const { return triggers; }
+
+    // Copia las posiciones a los sprites (en unidades de mundo) y rearma su
+    // grilla. Quien dibuja tiene que incrementar spriteVersion.
+    void ApplyTo(SpriteSet& set, float blockSize) const {
+        for (int i = 0; i < Count(); i++) {
+            if (sprite[i] < 0) continue;
+            set.x[sprite[i]] = x[i] * blockSize;
+            set.y[sprite[i]] = y[i] * blockSize;
+        }
+        set.RebuildGrid();
+    }
+
+private:
+    void StepRange(const MapView& map, int begin, int end, std::vector<EntityTrigger>& out) {
+        // Prueba rapida de todas, sin ramas: si el rectangulo barrido cae
+        // dentro del mapa, abarca a lo sumo 2 x 2 celdas y las cuatro estan
+        // vacias (lo mismo que AreaFree), la entidad avanza aqui; las demas
+        // quedan marcadas para MoveCircle
+        float r = radius;
+        int lastX = map.width - 1, lastY = map.height - 1;
+        for (int i = begin; i < end; i++) {
+            float newX = x[i] + velX[i], newY = y[i] + velY[i];
+            float x0 = std::min(x[i], newX) - r, x1 = std::max(x[i], newX) + r;
+            float y0 = std::min(y[i], newY) - r, y1 = std::max(y[i], newY) + r;
+            bool inside = x0 >= 0 && y0 >= 0 && x1 < map.width && y1 < map.height;
+            int cx0 = std::clamp((int)x0, 0, lastX), cx1 = std::clamp((int)x1, 0, lastX);
+            int cy0 = std::clamp((int)y0, 0, lastY), cy1 = std::clamp((int)y1, 0, lastY);
+            bool narrow = cx1 - cx0 <= 1 && cy1 - cy0 <= 1;
+            cx1 = std::min(cx1, cx0 + 1);
+            cy1 = std::min(cy1, cy0 + 1);
+            const uint8_t* row0 = map.cells + (size_t)cy0 * map.width;
+            const uint8_t* row1 = map.cells + (size_t)cy1 * map.width;
+            bool free = inside && narrow && (row0[cx0] | row0[cx1] | row1[cx0] | row1[cx1]) == 0;
+            x[i] = free ? newX : x[i];
+            y[i] = free ? newY : y[i];
+            nearWall[i] = !free;
+        }
+
+        for (int i = begin; i < end; i++) {
+            if (!nearWall[i]) continue;
+            MoveResult move = MoveCircle(map, x[i], y[i], radius, velX[i], velY[i]);
+            if (!move.blocked) continue;
+            // Rebotar: reflejar la parte de la velocidad que va contra la pared
+            float into = velX[i] * move.normalX + velY[i] * move.normalY;
+            if (into < 0) {
+                velX[i] -= 2 * into * move.normalX;
+                velY[i] -= 2 * into * move.normalY;
+            }
+            if (move.goalX >= 0) out.push_back({i, move.goalX, move.goalY});
+        }
+    }
+
+    std::vector<uint8_t> nearWall;
+    std::vector<std::vector<EntityTrigger>> taskTriggers;
+    std::vector<EntityTrigger> triggers;
+};
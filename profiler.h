@@ -0,0 +1,182 @@
+#pragma once
+
+// Perfilador de frames: temporizadores por alcance (PROFILE_SCOPE) que
+// guardan cada etapa en un buffer circular por hilo, sin bloqueos. Desde el
+// hilo principal, entre frames, se puede sumar el tiempo por etapa de un
+// frame, leer el historial de duracion de frames y exportar todo a un trace
+// de Chrome (chrome://tracing o Perfetto) o a CSV.
+//
+// Activo en compilaciones de depuracion; con NDEBUG desaparece por completo
+// (PROFILE_SCOPE y PROFILE_FRAME no generan codigo) salvo que se defina
+// RAYCASTER_PROFILE.
+
+#if !defined(NDEBUG) || defined(RAYCASTER_PROFILE)
+#define RAYCASTER_PROFILING 1
+#endif
+
+#ifdef RAYCASTER_PROFILING
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+const int PROFILE_RING_SIZE = 1 << 14;     // Eventos por hilo
+const int PROFILE_HISTORY_SIZE = 240;      // Frames en el historial
+const int PROFILE_MAX_STAGES = 32;
+
+struct ProfileEvent {
+    const char* name;       // Literal de cadena: se compara por puntero
+    uint64_t start, end;    // Nanosegundos desde el inicio del programa
+    uint32_t frame;
+};
+
+// Buffer circular de un hilo. Solo su hilo escribe; los lectores leen los
+// eventos anteriores a head, y solo entre frames (cuando los hilos del pool
+// estan quietos), asi que no pisan eventos a medio escribir.
+struct ProfileRing {
+    ProfileEvent events[PROFILE_RING_SIZE];
+    std::atomic<uint64_t> head{0};
+    int threadIndex = 0;
+
+    void Push(const ProfileEvent& event) {
+        uint64_t index = head.load(std::memory_order_relaxed);
+        events[index % PROFILE_RING_SIZE] = event;
+        head.store(index + 1, std::memory_order_release);
+    }
+};
+
+struct ProfileStage {
+    const char* name;
+    double ms;
+};
+
+inline std::chrono::steady_clock::time_point profileEpoch = std::chrono::steady_clock::now();
+inline std::atomic<uint32_t> profileFrame{0};
+inline std::mutex profileRingsMutex;
+inline std::vector<ProfileRing*> profileRings;  // Uno por hilo; viven hasta el final del programa
+inline float profileHistory[PROFILE_HISTORY_SIZE];
+inline int profileHistoryCount = 0;
+inline uint64_t profileFrameStart = 0;
+
+inline uint64_t ProfileNow() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profileEpoch).count();
+}
+
+// Buffer del hilo actual; se registra la primera vez (unico paso con lock)
+inline ProfileRing& ProfileThreadRing() {
+    thread_local ProfileRing* ring = [] {
+        ProfileRing* created = new ProfileRing();
+        std::lock_guard<std::mutex> lock(profileRingsMutex);
+        created->threadIndex = (int)profileRings.size();
+        profileRings.push_back(created);
+        return created;
+    }();
+    return *ring;
+}
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* stageName) : name(stageName), start(ProfileNow()) {}
+    ~ProfileScope() {
+        ProfileThreadRing().Push({name, start, ProfileNow(), profileFrame.load(std::memory_order_relaxed)});
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name;
+    uint64_t start;
+};
+
+// Marca el inicio de un frame (hilo principal) y guarda la duracion del anterior
+inline void ProfileBeginFrame() {
+    uint64_t now = ProfileNow();
+    if (profileFrameStart != 0) {
+        profileHistory[profileHistoryCount % PROFILE_HISTORY_SIZE] = (float)((now - profileFrameStart) / 1e6);
+        profileHistoryCount++;
+    }
+    profileFrameStart = now;
+    profileFrame.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline uint32_t ProfileCurrentFrame() {
+    return profileFrame.load(std::memory_order_relaxed);
+}
+
+// Llama a visit(event, threadIndex) con cada evento guardado, de todos los hilos
+template <class Visit>
+void ProfileForEachEvent(Visit visit) {
+    std::lock_guard<std::mutex> lock(profileRingsMutex);
+    for (const ProfileRing* ring : profileRings) {
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t first = head > PROFILE_RING_SIZE ? head - PROFILE_RING_SIZE : 0;
+        for (uint64_t i = first; i < head; i++) visit(ring->events[i % PROFILE_RING_SIZE], ring->threadIndex);
+    }
+}
+
+// Milisegundos por etapa de un frame, sumando todos los hilos (una etapa
+// que corre en paralelo suma el tiempo de cada hilo). Devuelve cuantas hay.
+inline int ProfileStageTimes(uint32_t frame, ProfileStage* stages, int maxStages) {
+    int count = 0;
+    ProfileForEachEvent([&](const ProfileEvent& event, int) {
+        if (event.frame != frame) return;
+        int i = 0;
+        while (i < count && stages[i].name != event.name) i++;
+        if (i == count) {
+            if (count == maxStages) return;
+            stages[count++] = {event.name, 0.0};
+        }
+        stages[i].ms += (event.end - event.start) / 1e6;
+    });
+    return count;
+}
+
+// Duracion del frame "age" frames atras (0 = el ultimo terminado)
+inline int ProfileHistoryCount() {
+    return profileHistoryCount < PROFILE_HISTORY_SIZE ? profileHistoryCount : PROFILE_HISTORY_SIZE;
+}
+
+inline float ProfileFrameMs(int age) {
+    return profileHistory[(profileHistoryCount - 1 - age) % PROFILE_HISTORY_SIZE];
+}
+
+// Trace en formato JSON de Chrome: un evento completo ("ph": "X") por etapa
+inline bool ProfileWriteChromeTrace(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) return false;
+    fprintf(file, "{\"traceEvents\":[\n");
+    bool first = true;
+    ProfileForEachEvent([&](const ProfileEvent& event, int thread) {
+        fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u}}",
+                first ? "" : ",\n", event.name, thread, event.start / 1e3, (event.end - event.start) / 1e3, event.frame);
+        first = false;
+    });
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+}
+
+inline bool ProfileWriteCsv(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) return false;
+    fprintf(file, "frame,thread,stage,start_us,duration_us\n");
+    ProfileForEachEvent([&](const ProfileEvent& event, int thread) {
+        fprintf(file, "%u,%d,%s,%.3f,%.3f\n", event.frame, thread, event.name, event.start / 1e3, (event.end - event.start) / 1e3);
+    });
+    return fclose(file) == 0;
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FRAME() ProfileBeginFrame()
+
+#else
+
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+
+#endif // RAYCASTER_PROFILING
@@ -0,0 +1,545 @@
+#pragma once
+
+// Conjunto potencialmente visible (PVS) por celda.
+//
+// Para cada celda vacia guarda que celdas se pueden ver desde algun punto
+// de ella: un rectangulo que las contiene, la distancia maxima a la que
+// estan y, dentro del rectangulo, un mapa de bits comprimido por tramos
+// (largos alternados de ceros y unos, fila mayor, en varints). En un
+// laberinto cada celda ve unos pocos pasillos, asi que los sprites que no
+// estan en el PVS de la celda de la camara se descartan sin proyectarlos, y
+// ningun rayo puede ir mas lejos que esa distancia.
+//
+// Se calcula con las rectas que cruzan la celda, no con rayos sueltos: en
+// cada una de las cuatro direcciones las rectas de pendiente a lo sumo 1
+// forman unos pocos poligonos convexos en el espacio de rectas (pendiente,
+// altura), que se recortan columna por columna a los huecos entre paredes.
+// Asi el conjunto incluye todo lo que se ve desde cualquier punto de la
+// celda (y algo mas: las vecinas de lo visible, por los sprites que asoman
+// de su celda). Cuesta del orden de las celdas vacias por el largo de sus
+// pasillos: sirve para mapas tipo laberinto; en mapas abiertos grandes cada
+// celda ve casi todo el mapa y el conjunto no descarta nada.
+//
+// Cuando una celda del mapa cambia, UpdateCell no recalcula en el momento:
+// si la celda se vuelve pared lo visible solo se achica y las entradas
+// viejas siguen sirviendo; si se abre, las celdas que la veian quedan sin
+// entrada (no descartan nada) y pendientes. El recalculo de las pendientes
+// es un PvsUpdate: StartUpdate copia el mapa, ComputeUpdate corre en
+// cualquier hilo (el juego lo manda al cargador de assets) y FinishUpdate
+// instala el resultado si el mapa no cambio mientras tanto.
+//
+// Formato serializado (dentro del archivo de nivel, ver level_format.h):
+//
+//   PvsIndex                 width, height
+//   uint32_t[width * height] offset de la entrada de cada celda desde el
+//                            inicio del bloque, o PVS_NO_ENTRY
+//   entradas                 PvsEntryHeader y sus tramos, alineadas a 4
+
+#include "raycast.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+const uint32_t PVS_NO_ENTRY = 0xFFFFFFFFu;
+const int PVS_MAX_SIZE = 0xFFFF;        // Lado maximo del mapa (el rectangulo usa 16 bits)
+const size_t PVS_MAX_POLYGONS = 4096;   // Grupos de rectas por barrido antes de darse por vencido
+
+struct PvsIndex {
+    uint32_t width, height;
+};
+
+struct PvsEntryHeader {
+    uint16_t x0, y0;        // Rectangulo de las celdas visibles
+    uint16_t width, height;
+    float maxDistance;      // Celdas desde cualquier punto de la celda hasta la mas lejana visible
+    uint32_t size;          // Bytes de tramos que siguen
+};
+
+static_assert(sizeof(PvsIndex) == 8, "PvsIndex debe medir 8 bytes");
+static_assert(sizeof(PvsEntryHeader) == 16, "PvsEntryHeader debe medir 16 bytes");
+
+// PVS de una celda ya descomprimido
+struct PvsCell {
+    int x0 = 0, y0 = 0, width = 0, height = 0;
+    float maxDistance = 0.0f;
+    std::vector<uint64_t> bits;
+
+    bool Contains(int x, int y) const {
+        unsigned dx = (unsigned)(x - x0), dy = (unsigned)(y - y0);
+        if (dx >= (unsigned)width || dy >= (unsigned)height) return false;
+        size_t bit = (size_t)dy * width + dx;
+        return (bits[bit >> 6] >> (bit & 63)) & 1;
+    }
+};
+
+// Recalculo de las celdas pendientes sobre una copia del mapa
+struct PvsUpdate {
+    uint32_t version = 0;           // Del conjunto al empezar
+    int width = 0, height = 0;
+    std::vector<uint8_t> cells;
+    std::vector<int> pending;       // Indices de celda a recalcular
+    std::unordered_map<int, std::vector<uint8_t>> entries;     // Resultado: entrada por celda (ninguna si es pared)
+};
+
+class PotentiallyVisibleSet {
+public:
+    PotentiallyVisibleSet() = default;
+
+    // entries apunta dentro de owned: se puede mover pero no copiar
+    PotentiallyVisibleSet(const PotentiallyVisibleSet&) = delete;
+    PotentiallyVisibleSet& operator=(const PotentiallyVisibleSet&) = delete;
+    PotentiallyVisibleSet(PotentiallyVisibleSet&& other) noexcept { *this = std::move(other); }
+    PotentiallyVisibleSet& operator=(PotentiallyVisibleSet&& other) noexcept {
+        width = other.width;
+        height = other.height;
+        entries = std::move(other.entries);
+        owned = std::move(other.owned);
+        pending = std::move(other.pending);
+        version = ++nextVersion;
+        other.Clear();
+        return *this;
+    }
+
+    bool IsLoaded() const { return width > 0; }
+
+    void Clear() {
+        width = height = 0;
+        entries.clear();
+        owned.clear();
+        pending.clear();
+        version = ++nextVersion;
+    }
+
+    // Usa el bloque serializado de un nivel (sin copiarlo; tiene que vivir
+    // mientras se use). Devuelve false si el bloque no es valido.
+    bool Load(const uint8_t* blob, size_t size, int mapWidth, int mapHeight) {
+        Clear();
+        if (size < sizeof(PvsIndex)) return false;
+        PvsIndex index;
+        memcpy(&index, blob, sizeof(index));
+        size_t cells = (size_t)mapWidth * mapHeight;
+        if ((int)index.width != mapWidth || (int)index.height != mapHeight || (size - sizeof(index)) / sizeof(uint32_t) < cells) return false;
+
+        std::vector<const uint8_t*> list(cells, nullptr);
+        const uint8_t* offsets = blob + sizeof(index);
+        for (size_t i = 0; i < cells; i++) {
+            uint32_t offset;
+            memcpy(&offset, offsets + i * sizeof(uint32_t), sizeof(offset));
+            if (offset == PVS_NO_ENTRY) continue;
+            if (offset > size || size - offset < sizeof(PvsEntryHeader)) return false;
+            PvsEntryHeader header;
+            memcpy(&header, blob + offset, sizeof(header));
+            if (header.size > size - offset - sizeof(header) || header.x0 + header.width > mapWidth ||
+                header.y0 + header.height > mapHeight) return false;
+            list[i] = blob + offset;
+        }
+        width = mapWidth;
+        height = mapHeight;
+        entries = std::move(list);
+        return true;
+    }
+
+    // Calcula el PVS de todas las celdas vacias de map
+    void Build(const MapView& map) {
+        Clear();
+        if (map.width > PVS_MAX_SIZE || map.height > PVS_MAX_SIZE) return;
+        width = map.width;
+        height = map.height;
+        entries.assign((size_t)width * height, nullptr);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) Recompute(map, x, y);
+        }
+    }
+
+    // Bloque serializado, para guardarlo en el nivel
+    std::vector<uint8_t> Serialize() const {
+        std::vector<uint8_t> blob(sizeof(PvsIndex) + entries.size() * sizeof(uint32_t));
+        PvsIndex index = {(uint32_t)width, (uint32_t)height};
+        memcpy(blob.data(), &index, sizeof(index));
+        for (size_t i = 0; i < entries.size(); i++) {
+            uint32_t offset = PVS_NO_ENTRY;
+            if (entries[i] != nullptr) {
+                offset = (uint32_t)blob.size();
+                PvsEntryHeader header;
+                memcpy(&header, entries[i], sizeof(header));
+                blob.insert(blob.end(), entries[i], entries[i] + sizeof(header) + header.size);
+                blob.resize((blob.size() + 3) & ~(size_t)3, 0);
+            }
+            memcpy(blob.data() + sizeof(index) + i * sizeof(uint32_t), &offset, sizeof(offset));
+        }
+        return blob;
+    }
+
+    // Despues de cambiar la celda (x, y) del mapa. Si ahora es pared basta
+    // quitar su entrada. Si se abrio, solo pueden ver mas las celdas que la
+    // veian: quedan sin entrada y pendientes, junto con la celda misma.
+    void UpdateCell(const MapView& map, int x, int y) {
+        if (!IsLoaded() || x < 0 || y < 0 || x >= width || y >= height) return;
+        size_t cell = (size_t)y * width + x;
+        if (map.cells[cell] != 0) {
+            entries[cell] = nullptr;
+            owned.erase((int)cell);
+        } else {
+            for (size_t i = 0; i < entries.size(); i++) {
+                if (entries[i] == nullptr || !EntryContains(entries[i], x, y)) continue;
+                entries[i] = nullptr;
+                owned.erase((int)i);
+                pending.push_back((int)i);
+            }
+            entries[cell] = nullptr;
+            owned.erase((int)cell);
+            pending.push_back((int)cell);
+        }
+        version = ++nextVersion;
+    }
+
+    bool HasPendingCells() const { return !pending.empty(); }
+
+    // Solo el hilo que modifica el mapa: copia lo que necesita el recalculo
+    PvsUpdate StartUpdate(const MapView& map) const {
+        PvsUpdate update;
+        update.version = version;
+        update.width = width;
+        update.height = height;
+        update.cells.assign(map.cells, map.cells + (size_t)width * height);
+        update.pending = pending;
+        std::sort(update.pending.begin(), update.pending.end());
+        update.pending.erase(std::unique(update.pending.begin(), update.pending.end()), update.pending.end());
+        return update;
+    }
+
+    // Calcula las entradas de update.pending; no toca ningun conjunto, asi
+    // que puede correr en otro hilo
+    static void ComputeUpdate(PvsUpdate& update) {
+        PotentiallyVisibleSet worker;
+        worker.width = update.width;
+        worker.height = update.height;
+        worker.entries.assign((size_t)update.width * update.height, nullptr);
+        MapView map = {update.cells.data(), update.width, update.height};
+        for (int i : update.pending) worker.Recompute(map, i % update.width, i / update.width);
+        update.entries = std::move(worker.owned);
+    }
+
+    // Instala las entradas de update; false (y siguen pendientes) si el
+    // conjunto cambio desde StartUpdate
+    bool FinishUpdate(PvsUpdate& update) {
+        if (update.version != version) return false;
+        for (auto& result : update.entries) {
+            std::vector<uint8_t>& entry = owned[result.first];
+            entry = std::move(result.second);
+            entries[result.first] = entry.data();
+        }
+        pending.clear();
+        version = ++nextVersion;
+        return true;
+    }
+
+    // Recalcula las celdas pendientes en el hilo actual
+    void RecomputePending(const MapView& map) {
+        if (pending.empty()) return;
+        PvsUpdate update = StartUpdate(map);
+        ComputeUpdate(update);
+        FinishUpdate(update);
+    }
+
+    // PVS de la celda (x, y), o nullptr si no tiene (pared o fuera del mapa).
+    // Descomprime en memoria de cada hilo y lo reusa mientras la celda no
+    // cambie, asi que el puntero vale hasta la siguiente llamada del hilo.
+    const PvsCell* Lookup(int x, int y) const {
+        if (!IsLoaded() || x < 0 || y < 0 || x >= width || y >= height) return nullptr;
+        const uint8_t* entry = entries[(size_t)y * width + x];
+        if (entry == nullptr) return nullptr;
+        thread_local struct {
+            const PotentiallyVisibleSet* owner = nullptr;
+            uint32_t version = 0;
+            const uint8_t* entry = nullptr;
+            PvsCell cell;
+        } cache;
+        if (cache.owner != this || cache.version != version || cache.entry != entry) {
+            Decode(entry, cache.cell);
+            cache.owner = this;
+            cache.version = version;
+            cache.entry = entry;
+        }
+        return &cache.cell;
+    }
+
+    // Bytes de las entradas comprimidas
+    size_t EncodedBytes() const {
+        size_t total = 0;
+        for (const uint8_t* entry : entries) {
+            if (entry == nullptr) continue;
+            PvsEntryHeader header;
+            memcpy(&header, entry, sizeof(header));
+            total += sizeof(header) + header.size;
+        }
+        return total;
+    }
+
+private:
+    static void Decode(const uint8_t* entry, PvsCell& out) {
+        PvsEntryHeader header;
+        memcpy(&header, entry, sizeof(header));
+        out.x0 = header.x0;
+        out.y0 = header.y0;
+        out.width = header.width;
+        out.height = header.height;
+        out.maxDistance = header.maxDistance;
+        size_t total = (size_t)header.width * header.height;
+        out.bits.assign((total + 63) / 64, 0);
+
+        // Tramos alternados, empezando por ceros; los bytes y bits de mas se ignoran
+        const uint8_t* run = entry + sizeof(header);
+        const uint8_t* end = run + header.size;
+        size_t bit = 0;
+        bool ones = false;
+        while (run < end && bit < total) {
+            uint64_t length = 0;
+            int shift = 0;
+            while (run < end && shift < 64) {
+                uint8_t byte = *run++;
+                length |= (uint64_t)(byte & 0x7F) << shift;
+                shift += 7;
+                if ((byte & 0x80) == 0) break;
+            }
+            size_t stop = (size_t)std::min<uint64_t>(total, bit + length);
+            if (ones) {
+                for (; bit < stop; bit++) out.bits[bit >> 6] |= (uint64_t)1 << (bit & 63);
+            }
+            bit = stop;
+            ones = !ones;
+        }
+    }
+
+    // Como Decode(entry).Contains(x, y), recorriendo los tramos sin
+    // descomprimir
+    static bool EntryContains(const uint8_t* entry, int x, int y) {
+        PvsEntryHeader header;
+        memcpy(&header, entry, sizeof(header));
+        unsigned dx = (unsigned)(x - header.x0), dy = (unsigned)(y - header.y0);
+        if (dx >= header.width || dy >= header.height) return false;
+        uint64_t target = (uint64_t)dy * header.width + dx;
+        const uint8_t* run = entry + sizeof(header);
+        const uint8_t* end = run + header.size;
+        uint64_t bit = 0;
+        bool ones = false;
+        while (run < end) {
+            uint64_t length = 0;
+            int shift = 0;
+            while (run < end && shift < 64) {
+                uint8_t byte = *run++;
+                length |= (uint64_t)(byte & 0x7F) << shift;
+                shift += 7;
+                if ((byte & 0x80) == 0) break;
+            }
+            if (target < bit + length) return ones;
+            bit += length;
+            ones = !ones;
+        }
+        return false;
+    }
+
+    // Recta y = b + m * u en coordenadas locales de un barrido (u a lo largo
+    // del barrido, desde el borde de la celda de origen; y a lo ancho)
+    struct DualPoint {
+        double m, b;
+    };
+    using DualPolygon = std::vector<DualPoint>;
+
+    // Conserva la parte del poligono con a * m + c * b <= d
+    static void ClipDual(const DualPolygon& in, double a, double c, double d, DualPolygon& out) {
+        out.clear();
+        for (size_t k = 0; k < in.size(); k++) {
+            const DualPoint& p = in[k];
+            const DualPoint& q = in[(k + 1) % in.size()];
+            double dp = a * p.m + c * p.b - d, dq = a * q.m + c * q.b - d;
+            if (dp <= 0) out.push_back(p);
+            if ((dp <= 0) != (dq <= 0)) {
+                double t = dp / (dp - dq);
+                out.push_back({p.m + t * (q.m - p.m), p.b + t * (q.b - p.b)});
+            }
+        }
+    }
+
+    static double DualArea(const DualPolygon& polygon) {
+        double area = 0;
+        for (size_t k = 0; k < polygon.size(); k++) {
+            const DualPoint& p = polygon[k];
+            const DualPoint& q = polygon[(k + 1) % polygon.size()];
+            area += p.m * q.b - q.m * p.b;
+        }
+        return fabs(area) / 2;
+    }
+
+    // Marca lo que ven desde la celda (x, y) las rectas de pendiente a lo
+    // sumo 1 en una direccion (0 = +x, 1 = -x, 2 = +y, 3 = -y). Las rectas
+    // que cruzan la celda se guardan como poligonos convexos en el plano
+    // (m, b); en cada columna se marcan las filas que tocan y se recortan a
+    // los huecos entre paredes de esa columna, asi que lo que queda es
+    // exactamente el conjunto de rectas libres hasta ahi (mas las que pasan
+    // junto a la celda de origen por sus vecinas, que se dejan por las dudas).
+    template <class Mark>
+    void SweepLines(const MapView& map, int x, int y, int direction, Mark mark) {
+        bool alongX = direction < 2;
+        int sign = direction % 2 == 0 ? 1 : -1;
+        int origin = alongX ? x : y;
+        int across = alongX ? y : x;
+        int rows = alongX ? height : width;
+        int columns = sign > 0 ? (alongX ? width : height) - 1 - origin : origin;
+        auto solid = [&](int column, int row) {
+            int main = origin + sign * column;
+            return alongX ? map.cells[(size_t)row * width + main] != 0 : map.cells[(size_t)main * width + row] != 0;
+        };
+        auto markAt = [&](int column, int row) {
+            int main = origin + sign * column;
+            if (alongX) mark(main, row);
+            else mark(row, main);
+        };
+
+        // La celda de origen ocupa u en [-1, 0] y a lo ancho [across, across + 1]
+        DualPolygon box = {{-1, across - 2.0}, {1, across - 2.0}, {1, across + 3.0}, {-1, across + 3.0}};
+        DualPolygon half, clipped;
+        current.clear();
+        ClipDual(box, -1, 0, 0, half);              // m >= 0: b >= across y b - m <= across + 1
+        ClipDual(half, 0, -1, -across, clipped);
+        ClipDual(clipped, -1, 1, across + 1, half);
+        current.push_back(half);
+        ClipDual(box, 1, 0, 0, half);               // m <= 0: b <= across + 1 y b - m >= across
+        ClipDual(half, 0, 1, across + 1, clipped);
+        ClipDual(clipped, 1, -1, -across, half);
+        current.push_back(half);
+
+        const double epsilon = 1e-9;
+        for (int column = 1; column <= columns && !current.empty(); column++) {
+            // Demasiados poligonos (mapas muy abiertos): se da por visible
+            // todo lo que queda en esta direccion
+            if (current.size() > PVS_MAX_POLYGONS) {
+                for (int c = column; c <= columns; c++) {
+                    for (int row = 0; row < rows; row++) markAt(c, row);
+                }
+                return;
+            }
+
+            next.clear();
+            double u0 = column - 1, u1 = column;
+            for (const DualPolygon& polygon : current) {
+                if (polygon.size() < 3) continue;
+                double low = 1e30, high = -1e30;
+                for (const DualPoint& p : polygon) {
+                    low = std::min({low, p.b + p.m * u0, p.b + p.m * u1});
+                    high = std::max({high, p.b + p.m * u0, p.b + p.m * u1});
+                }
+                int row0 = std::max(0, (int)floor(low)), row1 = std::min(rows - 1, (int)ceil(high) - 1);
+                for (int row = row0; row <= row1; row++) markAt(column, row);
+
+                // Un hueco es una tira de filas vacias; sus rectas no tocan
+                // ninguna pared de la columna
+                for (int row = row0; row <= row1; row++) {
+                    if (solid(column, row)) continue;
+                    int gapEnd = row;
+                    while (gapEnd + 1 < rows && !solid(column, gapEnd + 1)) gapEnd++;
+                    int gapStart = row;
+                    while (gapStart > 0 && !solid(column, gapStart - 1)) gapStart--;
+                    double g0 = gapStart - epsilon, g1 = gapEnd + 1 + epsilon;
+                    ClipDual(polygon, -u0, -1, -g0, half);
+                    ClipDual(half, u0, 1, g1, clipped);
+                    ClipDual(clipped, -u1, -1, -g0, half);
+                    ClipDual(half, u1, 1, g1, clipped);
+                    if (clipped.size() >= 3 && DualArea(clipped) > 1e-15) next.push_back(clipped);
+                    row = gapEnd;
+                }
+            }
+            std::swap(current, next);
+        }
+    }
+
+    // Recalcula la entrada de la celda (x, y): ninguna si es pared
+    void Recompute(const MapView& map, int x, int y) {
+        size_t index = (size_t)y * width + x;
+        entries[index] = nullptr;
+        owned.erase((int)index);
+        if (map.cells[index] != 0) return;
+
+        scratch.resize((size_t)width * height, 0);
+        touched.clear();
+        auto mark = [this](int cx, int cy) {
+            uint8_t& seen = scratch[(size_t)cy * width + cx];
+            if (!seen) {
+                seen = 1;
+                touched.push_back(cy * width + cx);
+            }
+        };
+
+        mark(x, y);
+        for (int direction = 0; direction < 4; direction++) SweepLines(map, x, y, direction, mark);
+
+        // Agregar los vecinos de lo visible: un sprite que no esta en el
+        // centro de su celda puede asomar a una celda vecina
+        size_t marked = touched.size();
+        for (size_t i = 0; i < marked; i++) {
+            int cx = touched[i] % width, cy = touched[i] / width;
+            for (int ny = std::max(cy - 1, 0); ny <= std::min(cy + 1, height - 1); ny++) {
+                for (int nx = std::max(cx - 1, 0); nx <= std::min(cx + 1, width - 1); nx++) mark(nx, ny);
+            }
+        }
+
+        // Rectangulo y distancia maxima: entre los puntos mas alejados de la
+        // celda y de cada celda marcada
+        int x0 = width, y0 = height, x1 = -1, y1 = -1;
+        float maxDistance = 0.0f;
+        for (int cell : touched) {
+            int cx = cell % width, cy = cell / width;
+            x0 = std::min(x0, cx);
+            y0 = std::min(y0, cy);
+            x1 = std::max(x1, cx);
+            y1 = std::max(y1, cy);
+            float dx = (float)std::max(abs(cx + 1 - x), abs(x + 1 - cx));
+            float dy = (float)std::max(abs(cy + 1 - y), abs(y + 1 - cy));
+            maxDistance = std::max(maxDistance, sqrtf(dx * dx + dy * dy));
+        }
+
+        PvsEntryHeader header = {(uint16_t)x0, (uint16_t)y0, (uint16_t)(x1 - x0 + 1), (uint16_t)(y1 - y0 + 1), maxDistance, 0};
+        std::vector<uint8_t>& entry = owned[(int)index];
+        entry.assign(sizeof(header), 0);
+        uint64_t run = 0;
+        bool ones = false;
+        auto flush = [&entry](uint64_t length) {
+            do {
+                uint8_t byte = length & 0x7F;
+                length >>= 7;
+                entry.push_back(byte | (length != 0 ? 0x80 : 0));
+            } while (length != 0);
+        };
+        for (int cy = y0; cy <= y1; cy++) {
+            for (int cx = x0; cx <= x1; cx++) {
+                bool seen = scratch[(size_t)cy * width + cx] != 0;
+                if (seen != ones) {
+                    flush(run);
+                    run = 0;
+                    ones = seen;
+                }
+                run++;
+            }
+        }
+        flush(run);
+        header.size = (uint32_t)(entry.size() - sizeof(header));
+        memcpy(entry.data(), &header, sizeof(header));
+        entries[index] = entry.data();
+
+        for (int cell : touched) scratch[cell] = 0;
+    }
+
+    int width = 0, height = 0;
+    std::vector<const uint8_t*> entries;    // Por celda: su PvsEntryHeader, o nullptr
+    std::unordered_map<int, std::vector<uint8_t>> owned;    // Entradas calculadas aqui (no las del archivo)
+    uint32_t version = 0;      // Cambia con cada cambio de entradas (unico entre instancias, para la cache de Lookup)
+    static inline uint32_t nextVersion = 0;
+    std::vector<uint8_t> scratch;
+    std::vector<int> touched;
+    std::vector<DualPolygon> current, next;
+    std::vector<int> pending;       // Celdas sin entrada hasta el proximo FinishUpdate
+};
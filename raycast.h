@@ -0,0 +1,482 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RAYCAST_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+// Vista de solo lectura sobre la grilla del mapa: un byte por celda, fila
+// mayor, 0 = vacio. Despues de la ultima celda debe haber al menos 3 bytes
+// legibles, porque el gather de AVX2 lee 4 bytes por celda. emptySpace es
+// opcional (ver empty_space.h) y sigue la misma regla, igual que light, la
+// luz por celda (ver lighting.h; nullptr si el mapa no tiene iluminacion).
+// pvs es el conjunto potencialmente visible de cada celda (ver pvs.h), si
+// el mapa lo tiene.
+class PotentiallyVisibleSet;
+
+struct MapView {
+    const uint8_t* cells;
+    int width, height;
+    const uint8_t* emptySpace = nullptr;
+    const uint8_t* light = nullptr;
+    const PotentiallyVisibleSet* pvs = nullptr;
+};
+
+struct Intersect {
+    float distance;  // Distancia a lo largo del rayo (unidades de mundo)
+    char impact;     // Tipo de celda golpeada ('1'..'4')
+    int mapX, mapY;  // Celda golpeada
+    int side;        // 0 = cara vertical (se cruzo un borde en X), 1 = cara horizontal (borde en Y)
+    float wallX;     // Coordenada fraccional [0, 1) del impacto sobre la pared
+};
+
+// Cuantos de los valores first + (steps + m) * delta, con m en [0, limit < 256),
+// son <= bound (o < bound si strict). Los valores crecen con m, asi que basta
+// una busqueda binaria; se evaluan con la misma expresion que usa el DDA.
+inline int CountStepsBefore(float first, int steps, float delta, int limit, float bound, bool strict) {
+    int count = 0;
+    for (int jump = 128; jump > 0; jump >>= 1) {
+        int candidate = count + jump;
+        if (candidate > limit) continue;
+        float value = first + (float)(steps + candidate - 1) * delta;
+        if (strict ? value < bound : value <= bound) count = candidate;
+    }
+    return count;
+}
+
+// Recorrido DDA: visita cada celda que cruza el rayo exactamente una vez,
+// asi que el costo depende de las celdas atravesadas y no de la distancia.
+// (startX, startY) estan en unidades de mundo y (rayDirX, rayDirY) es unitario.
+//
+// La distancia al k-esimo borde en X se calcula como firstX + k * deltaDistX
+// (en lugar de ir sumando), para que saltar k bordes de una vez con el campo
+// de espacio vacio llegue exactamente al mismo estado que el paso a paso.
+inline Intersect TraceRay(const MapView& map, float startX, float startY, float rayDirX, float rayDirY, float blockSize) {
+    // Trabajar en coordenadas de celda
+    float posX = startX / blockSize;
+    float posY = startY / blockSize;
+    int mapX = (int)floorf(posX);
+    int mapY = (int)floorf(posY);
+
+    // Distancia que recorre el rayo para cruzar una celda completa en cada eje
+    float deltaDistX = (rayDirX == 0.0f) ? 1e30f : fabsf(1.0f / rayDirX);
+    float deltaDistY = (rayDirY == 0.0f) ? 1e30f : fabsf(1.0f / rayDirY);
+
+    // Distancia hasta el primer borde de celda en cada eje
+    int stepX, stepY;
+    float firstX, firstY;
+    if (rayDirX < 0) {
+        stepX = -1;
+        firstX = (posX - mapX) * deltaDistX;
+    } else {
+        stepX = 1;
+        firstX = (mapX + 1.0f - posX) * deltaDistX;
+    }
+    if (rayDirY < 0) {
+        stepY = -1;
+        firstY = (posY - mapY) * deltaDistY;
+    } else {
+        stepY = 1;
+        firstY = (mapY + 1.0f - posY) * deltaDistY;
+    }
+
+    int stepsX = 0, stepsY = 0; // Bordes cruzados en cada eje
+    int side = 0;
+    float t = 0.0f; // Distancia recorrida hasta el borde de la celda actual
+
+    while (true) {
+        char impact = 0;
+        int k = 0;
+        if (mapX < 0 || mapX >= map.width || mapY < 0 || mapY >= map.height) {
+            impact = '1';
+        } else if (map.cells[mapY * map.width + mapX] != 0) {
+            impact = (char)('0' + map.cells[mapY * map.width + mapX]);
+        } else if (map.emptySpace != nullptr) {
+            k = map.emptySpace[mapY * map.width + mapX];
+        }
+
+        if (impact) {
+            // Punto exacto del impacto sobre la cara de la celda
+            float wallX = (side == 0) ? posY + t * rayDirY : posX + t * rayDirX;
+            wallX -= floorf(wallX);
+            // Orientar la coordenada para que las texturas no salgan espejadas
+            if ((side == 0 && rayDirX < 0) || (side == 1 && rayDirY > 0)) {
+                wallX = 1.0f - wallX;
+            }
+            return {t * blockSize, impact, mapX, mapY, side, wallX};
+        }
+
+        if (k >= 2) {
+            // Las celdas a distancia < k estan vacias: saltar hasta el primer
+            // borde que saca al rayo de ese cuadro. En cada eje faltan k bordes.
+            float exitX = firstX + (float)(stepsX + k - 1) * deltaDistX;
+            float exitY = firstY + (float)(stepsY + k - 1) * deltaDistY;
+            if (exitX < exitY) {
+                int crossedY = CountStepsBefore(firstY, stepsY, deltaDistY, k - 1, exitX, false);
+                stepsX += k;
+                stepsY += crossedY;
+                mapX += stepX * k;
+                mapY += stepY * crossedY;
+                t = exitX;
+                side = 0;
+            } else {
+                int crossedX = CountStepsBefore(firstX, stepsX, deltaDistX, k - 1, exitY, true);
+                stepsX += crossedX;
+                stepsY += k;
+                mapX += stepX * crossedX;
+                mapY += stepY * k;
+                t = exitY;
+                side = 1;
+            }
+            continue;
+        }
+
+        // Avanzar a la siguiente celda por el borde mas cercano
+        float sideDistX = firstX + (float)stepsX * deltaDistX;
+        float sideDistY = firstY + (float)stepsY * deltaDistY;
+        if (sideDistX < sideDistY) {
+            t = sideDistX;
+            stepsX++;
+            mapX += stepX;
+            side = 0;
+        } else {
+            t = sideDistY;
+            stepsY++;
+            mapY += stepY;
+            side = 1;
+        }
+    }
+}
+
+// Entrada de un lote de columnas adyacentes que comparten origen
+struct RayBatch {
+    float startX, startY;   // Origen en unidades de mundo
+    const float* dirX;      // Direccion unitaria de cada rayo
+    const float* dirY;
+    const float* fisheye;   // Coseno del angulo entre cada rayo y la vista (quita el ojo de pez)
+    int count;
+};
+
+// Resultado por columna en estructura de arreglos (los arreglos los pone quien llama)
+struct WallHits {
+    float* distance;    // Distancia corregida (sin ojo de pez)
+    float* wallHeight;  // Altura proyectada de la pared en pixeles
+    int* brightness;    // 0..255, mismo calculo que el render por columna
+    int* cell;          // Valor de la celda golpeada (1 si el rayo salio del mapa)
+    int* side;
+    float* wallX;
+};
+
+enum RayKernel {
+    RAY_KERNEL_AUTO,
+    RAY_KERNEL_SCALAR,
+    RAY_KERNEL_SSE,   // Paquetes de 4 rayos (SSE4.1)
+    RAY_KERNEL_AVX2   // Paquetes de 8 rayos
+};
+
+inline const char* RayKernelName(RayKernel kernel) {
+    switch (kernel) {
+        case RAY_KERNEL_SCALAR: return "scalar";
+        case RAY_KERNEL_SSE: return "sse";
+        case RAY_KERNEL_AVX2: return "avx2";
+        default: return "auto";
+    }
+}
+
+// Mejor kernel que soporta el procesador donde corre el programa
+inline RayKernel DetectRayKernel() {
+#ifdef RAYCAST_X86_SIMD
+    static const RayKernel detected = __builtin_cpu_supports("avx2") ? RAY_KERNEL_AVX2
+                                    : __builtin_cpu_supports("sse4.1") ? RAY_KERNEL_SSE
+                                    : RAY_KERNEL_SCALAR;
+    return detected;
+#else
+    return RAY_KERNEL_SCALAR;
+#endif
+}
+
+// Sombreado y altura de una columna a partir del impacto; los kernels SIMD
+// repiten exactamente estas operaciones para dar el mismo resultado
+inline void ShadeColumnScalar(const RayBatch& batch, const Intersect& hit, float blockSize, float screenHeight, const WallHits& out, int i) {
+    float correctedDistance = hit.distance * batch.fisheye[i];
+    out.distance[i] = correctedDistance;
+    out.wallHeight[i] = (screenHeight / correctedDistance) * blockSize;
+    out.brightness[i] = (int)(255 / (1 + correctedDistance * 0.01f));
+    out.cell[i] = hit.impact - '0';
+    out.side[i] = hit.side;
+    out.wallX[i] = hit.wallX;
+}
+
+inline void CastRaysScalar(const MapView& map, const RayBatch& batch, float blockSize, float screenHeight, const WallHits& out, int first) {
+    for (int i = first; i < batch.count; i++) {
+        Intersect hit = TraceRay(map, batch.startX, batch.startY, batch.dirX[i], batch.dirY[i], blockSize);
+        ShadeColumnScalar(batch, hit, blockSize, screenHeight, out, i);
+    }
+}
+
+#ifdef RAYCAST_X86_SIMD
+
+// Paquete de 4 rayos. Los pasos del DDA son vectoriales; la lectura de las
+// celdas se hace carril por carril porque SSE no tiene gather. No usa el
+// campo de espacio vacio (el resultado es el mismo, solo mas lento).
+__attribute__((target("sse4.1")))
+inline int CastRaysSSE(const MapView& map, const RayBatch& batch, float blockSize, float screenHeight, const WallHits& out) {
+    float posX = batch.startX / blockSize;
+    float posY = batch.startY / blockSize;
+    int startMapX = (int)floorf(posX);
+    int startMapY = (int)floorf(posY);
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 posXv = _mm_set1_ps(posX);
+    const __m128 posYv = _mm_set1_ps(posY);
+    const __m128 mapXf = _mm_set1_ps((float)startMapX);
+    const __m128 mapYf = _mm_set1_ps((float)startMapY);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+
+    int i = 0;
+    for (; i + 4 <= batch.count; i += 4) {
+        __m128 dirX = _mm_loadu_ps(batch.dirX + i);
+        __m128 dirY = _mm_loadu_ps(batch.dirY + i);
+
+        __m128 deltaX = _mm_blendv_ps(_mm_andnot_ps(signMask, _mm_div_ps(one, dirX)), _mm_set1_ps(1e30f), _mm_cmpeq_ps(dirX, zero));
+        __m128 deltaY = _mm_blendv_ps(_mm_andnot_ps(signMask, _mm_div_ps(one, dirY)), _mm_set1_ps(1e30f), _mm_cmpeq_ps(dirY, zero));
+
+        __m128 negX = _mm_cmplt_ps(dirX, zero);
+        __m128 negY = _mm_cmplt_ps(dirY, zero);
+        __m128i stepX = _mm_blendv_epi8(_mm_set1_epi32(1), _mm_set1_epi32(-1), _mm_castps_si128(negX));
+        __m128i stepY = _mm_blendv_epi8(_mm_set1_epi32(1), _mm_set1_epi32(-1), _mm_castps_si128(negY));
+        __m128 firstX = _mm_blendv_ps(_mm_mul_ps(_mm_sub_ps(_mm_add_ps(mapXf, one), posXv), deltaX),
+                                      _mm_mul_ps(_mm_sub_ps(posXv, mapXf), deltaX), negX);
+        __m128 firstY = _mm_blendv_ps(_mm_mul_ps(_mm_sub_ps(_mm_add_ps(mapYf, one), posYv), deltaY),
+                                      _mm_mul_ps(_mm_sub_ps(posYv, mapYf), deltaY), negY);
+        __m128 stepsX = zero;
+        __m128 stepsY = zero;
+
+        __m128i mapX = _mm_set1_epi32(startMapX);
+        __m128i mapY = _mm_set1_epi32(startMapY);
+        __m128i side = _mm_setzero_si128();
+        __m128i hitCell = _mm_setzero_si128();
+        __m128 t = zero;
+        __m128 active = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+        while (_mm_movemask_ps(active)) {
+            __m128 sideX = _mm_add_ps(firstX, _mm_mul_ps(stepsX, deltaX));
+            __m128 sideY = _mm_add_ps(firstY, _mm_mul_ps(stepsY, deltaY));
+            __m128 xStep = _mm_and_ps(_mm_cmplt_ps(sideX, sideY), active);
+            __m128 yStep = _mm_andnot_ps(_mm_cmplt_ps(sideX, sideY), active);
+
+            t = _mm_blendv_ps(t, sideX, xStep);
+            t = _mm_blendv_ps(t, sideY, yStep);
+            stepsX = _mm_blendv_ps(stepsX, _mm_add_ps(stepsX, one), xStep);
+            stepsY = _mm_blendv_ps(stepsY, _mm_add_ps(stepsY, one), yStep);
+            mapX = _mm_add_epi32(mapX, _mm_and_si128(stepX, _mm_castps_si128(xStep)));
+            mapY = _mm_add_epi32(mapY, _mm_and_si128(stepY, _mm_castps_si128(yStep)));
+            side = _mm_blendv_epi8(side, _mm_setzero_si128(), _mm_castps_si128(xStep));
+            side = _mm_blendv_epi8(side, _mm_set1_epi32(1), _mm_castps_si128(yStep));
+
+            alignas(16) int mx[4], my[4], cells[4];
+            _mm_store_si128((__m128i*)mx, mapX);
+            _mm_store_si128((__m128i*)my, mapY);
+            for (int lane = 0; lane < 4; lane++) {
+                bool inside = mx[lane] >= 0 && mx[lane] < map.width && my[lane] >= 0 && my[lane] < map.height;
+                cells[lane] = inside ? map.cells[my[lane] * map.width + mx[lane]] : 1;
+            }
+            __m128i cell = _mm_load_si128((const __m128i*)cells);
+
+            __m128 hitNow = _mm_andnot_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(cell, _mm_setzero_si128())), active);
+            hitCell = _mm_blendv_epi8(hitCell, cell, _mm_castps_si128(hitNow));
+            active = _mm_andnot_ps(hitNow, active);
+        }
+
+        __m128 blockSizeV = _mm_set1_ps(blockSize);
+        __m128 corrected = _mm_mul_ps(_mm_mul_ps(t, blockSizeV), _mm_loadu_ps(batch.fisheye + i));
+        __m128 wallHeight = _mm_mul_ps(_mm_div_ps(_mm_set1_ps(screenHeight), corrected), blockSizeV);
+        __m128 brightness = _mm_div_ps(_mm_set1_ps(255.0f), _mm_add_ps(one, _mm_mul_ps(corrected, _mm_set1_ps(0.01f))));
+
+        __m128 sideIsX = _mm_castsi128_ps(_mm_cmpeq_epi32(side, _mm_setzero_si128()));
+        __m128 wallX = _mm_blendv_ps(_mm_add_ps(posXv, _mm_mul_ps(t, dirX)), _mm_add_ps(posYv, _mm_mul_ps(t, dirY)), sideIsX);
+        wallX = _mm_sub_ps(wallX, _mm_floor_ps(wallX));
+        __m128 flip = _mm_or_ps(_mm_and_ps(sideIsX, negX), _mm_andnot_ps(sideIsX, _mm_cmpgt_ps(dirY, zero)));
+        wallX = _mm_blendv_ps(wallX, _mm_sub_ps(one, wallX), flip);
+
+        _mm_storeu_ps(out.distance + i, corrected);
+        _mm_storeu_ps(out.wallHeight + i, wallHeight);
+        _mm_storeu_si128((__m128i*)(out.brightness + i), _mm_cvttps_epi32(brightness));
+        _mm_storeu_si128((__m128i*)(out.cell + i), hitCell);
+        _mm_storeu_si128((__m128i*)(out.side + i), side);
+        _mm_storeu_ps(out.wallX + i, wallX);
+    }
+    return i;
+}
+
+// Paquete de 8 rayos con gather de AVX2 para leer las celdas y el campo de
+// espacio vacio. Cada carril salta por su cuenta y el resto sigue paso a paso.
+__attribute__((target("avx2")))
+inline int CastRaysAVX2(const MapView& map, const RayBatch& batch, float blockSize, float screenHeight, const WallHits& out) {
+    float posX = batch.startX / blockSize;
+    float posY = batch.startY / blockSize;
+    int startMapX = (int)floorf(posX);
+    int startMapY = (int)floorf(posY);
+
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 posXv = _mm256_set1_ps(posX);
+    const __m256 posYv = _mm256_set1_ps(posY);
+    const __m256 mapXf = _mm256_set1_ps((float)startMapX);
+    const __m256 mapYf = _mm256_set1_ps((float)startMapY);
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    const __m256i zeroI = _mm256_setzero_si256();
+    const __m256i widthV = _mm256_set1_epi32(map.width);
+    const __m256i heightV = _mm256_set1_epi32(map.height);
+
+    int i = 0;
+    for (; i + 8 <= batch.count; i += 8) {
+        __m256 dirX = _mm256_loadu_ps(batch.dirX + i);
+        __m256 dirY = _mm256_loadu_ps(batch.dirY + i);
+
+        __m256 deltaX = _mm256_blendv_ps(_mm256_andnot_ps(signMask, _mm256_div_ps(one, dirX)), _mm256_set1_ps(1e30f), _mm256_cmp_ps(dirX, zero, _CMP_EQ_OQ));
+        __m256 deltaY = _mm256_blendv_ps(_mm256_andnot_ps(signMask, _mm256_div_ps(one, dirY)), _mm256_set1_ps(1e30f), _mm256_cmp_ps(dirY, zero, _CMP_EQ_OQ));
+
+        __m256 negX = _mm256_cmp_ps(dirX, zero, _CMP_LT_OQ);
+        __m256 negY = _mm256_cmp_ps(dirY, zero, _CMP_LT_OQ);
+        __m256i stepX = _mm256_blendv_epi8(_mm256_set1_epi32(1), _mm256_set1_epi32(-1), _mm256_castps_si256(negX));
+        __m256i stepY = _mm256_blendv_epi8(_mm256_set1_epi32(1), _mm256_set1_epi32(-1), _mm256_castps_si256(negY));
+        __m256 firstX = _mm256_blendv_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_add_ps(mapXf, one), posXv), deltaX),
+                                         _mm256_mul_ps(_mm256_sub_ps(posXv, mapXf), deltaX), negX);
+        __m256 firstY = _mm256_blendv_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_add_ps(mapYf, one), posYv), deltaY),
+                                         _mm256_mul_ps(_mm256_sub_ps(posYv, mapYf), deltaY), negY);
+        __m256 stepsX = zero;
+        __m256 stepsY = zero;
+
+        __m256i mapX = _mm256_set1_epi32(startMapX);
+        __m256i mapY = _mm256_set1_epi32(startMapY);
+        __m256i side = zeroI;
+        __m256i hitCell = zeroI;
+        __m256 t = zero;
+        __m256 active = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        // Carriles que acaban de saltar (o recien empiezan): revisan su celda
+        // actual antes de dar el siguiente paso
+        __m256 skipStep = active;
+
+        while (_mm256_movemask_ps(active)) {
+            __m256 sideX = _mm256_add_ps(firstX, _mm256_mul_ps(stepsX, deltaX));
+            __m256 sideY = _mm256_add_ps(firstY, _mm256_mul_ps(stepsY, deltaY));
+            __m256 xLess = _mm256_cmp_ps(sideX, sideY, _CMP_LT_OQ);
+            __m256 stepping = _mm256_andnot_ps(skipStep, active);
+            __m256 xStep = _mm256_and_ps(xLess, stepping);
+            __m256 yStep = _mm256_andnot_ps(xLess, stepping);
+
+            t = _mm256_blendv_ps(t, sideX, xStep);
+            t = _mm256_blendv_ps(t, sideY, yStep);
+            stepsX = _mm256_blendv_ps(stepsX, _mm256_add_ps(stepsX, one), xStep);
+            stepsY = _mm256_blendv_ps(stepsY, _mm256_add_ps(stepsY, one), yStep);
+            mapX = _mm256_add_epi32(mapX, _mm256_and_si256(stepX, _mm256_castps_si256(xStep)));
+            mapY = _mm256_add_epi32(mapY, _mm256_and_si256(stepY, _mm256_castps_si256(yStep)));
+            side = _mm256_blendv_epi8(side, zeroI, _mm256_castps_si256(xStep));
+            side = _mm256_blendv_epi8(side, _mm256_set1_epi32(1), _mm256_castps_si256(yStep));
+
+            // Dentro del mapa: 0 <= mapX < width y 0 <= mapY < height
+            __m256i inside = _mm256_and_si256(
+                _mm256_and_si256(_mm256_cmpgt_epi32(mapX, _mm256_set1_epi32(-1)), _mm256_cmpgt_epi32(widthV, mapX)),
+                _mm256_and_si256(_mm256_cmpgt_epi32(mapY, _mm256_set1_epi32(-1)), _mm256_cmpgt_epi32(heightV, mapY)));
+            __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(mapY, widthV), mapX);
+            // Fuera del mapa cuenta como pared tipo 1. Se leen 4 bytes por
+            // celda y se queda solo el primero.
+            __m256i cell = _mm256_mask_i32gather_epi32(_mm256_set1_epi32(1), (const int*)map.cells, index, inside, 1);
+            cell = _mm256_and_si256(cell, _mm256_set1_epi32(0xFF));
+
+            __m256 hitNow = _mm256_andnot_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(cell, zeroI)), active);
+            hitCell = _mm256_blendv_epi8(hitCell, cell, _mm256_castps_si256(hitNow));
+            active = _mm256_andnot_ps(hitNow, active);
+            skipStep = zero;
+
+            if (map.emptySpace == nullptr) continue;
+
+            // Salto sobre espacio vacio, igual que en TraceRay
+            __m256i k = _mm256_mask_i32gather_epi32(zeroI, (const int*)map.emptySpace, index,
+                                                    _mm256_and_si256(inside, _mm256_castps_si256(active)), 1);
+            k = _mm256_and_si256(k, _mm256_set1_epi32(0xFF));
+            __m256 jump = _mm256_and_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(k, _mm256_set1_epi32(1))), active);
+            if (!_mm256_movemask_ps(jump)) continue;
+
+            __m256 kf = _mm256_cvtepi32_ps(k);
+            __m256 limit = _mm256_sub_ps(kf, one);
+            __m256 exitX = _mm256_add_ps(firstX, _mm256_mul_ps(_mm256_add_ps(stepsX, limit), deltaX));
+            __m256 exitY = _mm256_add_ps(firstY, _mm256_mul_ps(_mm256_add_ps(stepsY, limit), deltaY));
+            __m256 xExit = _mm256_cmp_ps(exitX, exitY, _CMP_LT_OQ);
+
+            // Bordes cruzados en el otro eje antes de salir del cuadro
+            __m256 crossedY = zero;
+            __m256 crossedX = zero;
+            for (int jumpSize = 128; jumpSize > 0; jumpSize >>= 1) {
+                __m256 size = _mm256_set1_ps((float)jumpSize);
+                __m256 candY = _mm256_add_ps(crossedY, size);
+                __m256 valueY = _mm256_add_ps(firstY, _mm256_mul_ps(_mm256_sub_ps(_mm256_add_ps(stepsY, candY), one), deltaY));
+                __m256 okY = _mm256_and_ps(_mm256_cmp_ps(candY, limit, _CMP_LE_OQ), _mm256_cmp_ps(valueY, exitX, _CMP_LE_OQ));
+                crossedY = _mm256_blendv_ps(crossedY, candY, okY);
+
+                __m256 candX = _mm256_add_ps(crossedX, size);
+                __m256 valueX = _mm256_add_ps(firstX, _mm256_mul_ps(_mm256_sub_ps(_mm256_add_ps(stepsX, candX), one), deltaX));
+                __m256 okX = _mm256_and_ps(_mm256_cmp_ps(candX, limit, _CMP_LE_OQ), _mm256_cmp_ps(valueX, exitY, _CMP_LT_OQ));
+                crossedX = _mm256_blendv_ps(crossedX, candX, okX);
+            }
+
+            __m256 movedX = _mm256_blendv_ps(crossedX, kf, xExit);
+            __m256 movedY = _mm256_blendv_ps(kf, crossedY, xExit);
+            stepsX = _mm256_blendv_ps(stepsX, _mm256_add_ps(stepsX, movedX), jump);
+            stepsY = _mm256_blendv_ps(stepsY, _mm256_add_ps(stepsY, movedY), jump);
+            __m256i jumpI = _mm256_castps_si256(jump);
+            mapX = _mm256_add_epi32(mapX, _mm256_and_si256(_mm256_sign_epi32(_mm256_cvtps_epi32(movedX), stepX), jumpI));
+            mapY = _mm256_add_epi32(mapY, _mm256_and_si256(_mm256_sign_epi32(_mm256_cvtps_epi32(movedY), stepY), jumpI));
+            t = _mm256_blendv_ps(t, _mm256_blendv_ps(exitY, exitX, xExit), jump);
+            side = _mm256_blendv_epi8(side, _mm256_andnot_si256(_mm256_castps_si256(xExit), _mm256_set1_epi32(1)), jumpI);
+            skipStep = jump;
+        }
+
+        __m256 blockSizeV = _mm256_set1_ps(blockSize);
+        __m256 corrected = _mm256_mul_ps(_mm256_mul_ps(t, blockSizeV), _mm256_loadu_ps(batch.fisheye + i));
+        __m256 wallHeight = _mm256_mul_ps(_mm256_div_ps(_mm256_set1_ps(screenHeight), corrected), blockSizeV);
+        __m256 brightness = _mm256_div_ps(_mm256_set1_ps(255.0f), _mm256_add_ps(one, _mm256_mul_ps(corrected, _mm256_set1_ps(0.01f))));
+
+        __m256 sideIsX = _mm256_castsi256_ps(_mm256_cmpeq_epi32(side, zeroI));
+        __m256 wallX = _mm256_blendv_ps(_mm256_add_ps(posXv, _mm256_mul_ps(t, dirX)), _mm256_add_ps(posYv, _mm256_mul_ps(t, dirY)), sideIsX);
+        wallX = _mm256_sub_ps(wallX, _mm256_floor_ps(wallX));
+        __m256 flip = _mm256_or_ps(_mm256_and_ps(sideIsX, negX), _mm256_andnot_ps(sideIsX, _mm256_cmp_ps(dirY, zero, _CMP_GT_OQ)));
+        wallX = _mm256_blendv_ps(wallX, _mm256_sub_ps(one, wallX), flip);
+
+        _mm256_storeu_ps(out.distance + i, corrected);
+        _mm256_storeu_ps(out.wallHeight + i, wallHeight);
+        _mm256_storeu_si256((__m256i*)(out.brightness + i), _mm256_cvttps_epi32(brightness));
+        _mm256_storeu_si256((__m256i*)(out.cell + i), hitCell);
+        _mm256_storeu_si256((__m256i*)(out.side + i), side);
+        _mm256_storeu_ps(out.wallX + i, wallX);
+    }
+    return i;
+}
+
+#endif // RAYCAST_X86_SIMD
+
+// Lanza todos los rayos del lote con el kernel pedido (o el mejor disponible
+// con RAY_KERNEL_AUTO). Las columnas que no llenan un paquete van por el
+// camino escalar, que da exactamente el mismo resultado.
+inline void CastRays(const MapView& map, const RayBatch& batch, float blockSize, float screenHeight, const WallHits& out, RayKernel kernel = RAY_KERNEL_AUTO) {
+    if (kernel == RAY_KERNEL_AUTO || kernel > DetectRayKernel()) kernel = DetectRayKernel();
+
+    int done = 0;
+#ifdef RAYCAST_X86_SIMD
+    // Los paquetes asumen que el origen esta en una celda vacia del mapa
+    int startMapX = (int)floorf(batch.startX / blockSize);
+    int startMapY = (int)floorf(batch.startY / blockSize);
+    bool startEmpty = startMapX >= 0 && startMapX < map.width && startMapY >= 0 && startMapY < map.height &&
+                      map.cells[startMapY * map.width + startMapX] == 0;
+    if (startEmpty) {
+        if (kernel == RAY_KERNEL_AVX2) done = CastRaysAVX2(map, batch, blockSize, screenHeight, out);
+        else if (kernel == RAY_KERNEL_SSE) done = CastRaysSSE(map, batch, blockSize, screenHeight, out);
+    }
+#endif
+    CastRaysScalar(map, batch, blockSize, screenHeight, out, done);
+}
@@ -0,0 +1,942 @@
+#pragma once
+
+// Motor del raycaster: mundo, niveles y render por software de la vista 3D.
+// No usa la ventana ni el audio de raylib (solo sus tipos), asi que lo
+// comparten el juego (main.cpp) y el benchmark sin ventana (bench.cpp).
+
+#include "raylib.h"
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include "thread_pool.h"
+#include "raycast.h"
+#include "level_format.h"
+#include "asset_bundle.h"
+#include "sprites.h"
+#include "depth_pyramid.h"
+#include "texture_atlas.h"
+#include "sprite_texture.h"
+#include "floor_cast.h"
+#include "column_reuse.h"
+#include "lighting.h"
+#include "pvs.h"
+#include "profiler.h"
+
+const int SCREEN_WIDTH = 800;
+const int SCREEN_HEIGHT = 600;
+const float FOV = 60.0f * DEG2RAD;
+const float BLOCK_SIZE = 64.0f;
+const int SPRITE_SIZE = 32; // Tamaño de la textura del sprite
+const float SPRITE_WORLD_SIZE = BLOCK_SIZE / 2; // Alto del sprite en unidades de mundo
+const int TILE_WIDTH = 32;  // Columnas por tarea del renderizador paralelo
+const float SPRITE_GRID_CELL = 4 * BLOCK_SIZE; // Lado de las celdas de la grilla de sprites
+const int FLOOR_BAND_HEIGHT = 16; // Filas por tarea de la pasada de piso y techo
+
+// Mapa actual en uso: celdas del archivo del nivel (mapWidth x mapHeight,
+// fila mayor). Se leen y modifican directo sobre el archivo mapeado.
+inline LevelFile worldLevel;
+inline uint8_t* worldMap = nullptr;
+inline int mapWidth = 0;
+inline int mapHeight = 0;
+
+// Campo de espacio vacio del mapa actual (ver empty_space.h). Viene en el
+// archivo del nivel; si no, se calcula al cargar en emptySpaceStorage.
+inline uint8_t* emptySpace = nullptr;
+inline std::vector<uint8_t> emptySpaceStorage;
+
+// Luz por celda del mapa actual (ver lighting.h); vacia si el nivel no
+// tiene iluminacion
+inline LightGrid lightGrid;
+
+// PVS del mapa actual (ver pvs.h); vacio si el nivel no lo trae
+inline PotentiallyVisibleSet worldPvs;
+
+// Saltar espacio vacio al lanzar rayos (no cambia la imagen, solo el
+// costo); lo decide cada nivel al cargarlo (ver EmptySpaceWorthSkipping)
+inline bool emptySpaceSkipping = true;
+
+// Reusar el frame anterior cuando la camara no se mueve o solo gira (ver
+// RenderScene; tampoco cambia la imagen)
+inline bool temporalReuse = true;
+
+// Cambian con todo lo que afecta la imagen y no es la camara: sceneVersion
+// con las celdas del mapa y las texturas, spriteVersion con los sprites.
+// Quien mueva o desactive sprites a mano tiene que incrementar spriteVersion.
+inline uint32_t sceneVersion = 0;
+inline uint32_t spriteVersion = 0;
+inline int currentLevel = 1;
+
+// Paquete de assets del juego (ver asset_bundle.h). Si no esta abierto,
+// todo se carga de archivos sueltos o se genera.
+inline AssetBundle assetBundle;
+
+struct Player {
+    float x, y;        
+    float angle;       
+    bool hasWon;       
+};
+
+// Descripcion de un sprite para cargarlo en "sprites"
+struct Sprite {
+    float x, y;
+    int type; // 0 = cubo azul, 1 = cubo verde, 2 = cubo naranja
+};
+
+// Camara de un frame: posicion, direccion de vista (unitaria) y plano de
+// camara (perpendicular, de largo tan(FOV/2)). El rayo de la columna x es
+// dir + plane * cameraX[x]; se arma una vez por frame con un solo sin/cos.
+struct Camera {
+    float x, y;
+    float dirX, dirY;
+    float planeX, planeY;
+};
+
+// Tablas por columna que solo dependen de la resolucion y el FOV
+struct ColumnTables {
+    int width = 0;
+    float fov = 0;
+    std::vector<float> cameraX;     // Posicion en el plano de camara, de -1 a 1
+    std::vector<float> invLength;   // 1 / |dir + plane * cameraX|, que es tambien el coseno para quitar el ojo de pez
+    std::vector<float> angle;       // Angulo del rayo respecto de dir (creciente con x)
+};
+
+inline ColumnTables columnTables;
+
+// Sprites del mundo (ver sprites.h)
+inline SpriteSet sprites;
+
+// Buffer de profundidad para sprites (z-buffer), uno por columna de la
+// resolucion interna (se reserva para SCREEN_WIDTH)
+inline float* depthBuffer;
+
+// Maximos de depthBuffer por bloques de columnas, para descartar sprites tapados
+inline DepthPyramid depthPyramid;
+
+// Conteo de sprites del ultimo frame
+struct SpriteStats {
+    int inView;     // Dentro del cono de vision y en pantalla
+    int occluded;   // Descartados porque las paredes los tapan por completo
+    int drawn;      // Dibujados (visibles al menos en parte)
+};
+
+inline SpriteStats spriteStats;
+
+// Framebuffer en CPU para la vista 3D. Se reserva para SCREEN_WIDTH x
+// SCREEN_HEIGHT pero se usa a la resolucion interna renderWidth x
+// renderHeight (fila mayor, renderWidth pixeles por fila).
+inline Color* frameBuffer;
+
+// Resolucion interna de la vista 3D (ver SetRenderResolution)
+inline int renderWidth = SCREEN_WIDTH;
+inline int renderHeight = SCREEN_HEIGHT;
+
+// Donde se dibuja una vista 3D: pixeles en fila mayor (width por fila), la
+// profundidad de pared por columna con su piramide y las tablas de columnas
+// de ese ancho. El juego dibuja en MainRenderTarget; el render por lotes
+// (ver batch_render.h) arma uno por vista con memoria de cada hilo.
+struct RenderTarget {
+    Color* pixels;
+    int width, height;
+    float* depth;
+    DepthPyramid* pyramid;
+    const ColumnTables* columns;
+    float* pixelDepth = nullptr;    // Si no es nullptr, los sprites escriben aqui su profundidad por pixel
+};
+
+inline RenderTarget MainRenderTarget() {
+    return {frameBuffer, renderWidth, renderHeight, depthBuffer, &depthPyramid, &columnTables};
+}
+
+// Hilos que reparten las columnas de la vista 3D (1 = todo en el hilo principal)
+inline ThreadPool* renderPool;
+
+// Kernel de rayos para la pasada de paredes (AUTO = el mejor que soporte el CPU)
+inline RayKernel rayKernel = RAY_KERNEL_AUTO;
+
+// Reemplaza los sprites del mundo y arma su grilla sobre un mapa de
+// width x height celdas
+inline void SetSprites(const std::vector<Sprite>& list, int width, int height) {
+    sprites.Clear();
+    for (const Sprite& sprite : list) sprites.Add(sprite.x, sprite.y, sprite.type);
+    
+    // Con pocos sprites en un mapa grande, celdas mas grandes para que la
+    // grilla no pese mas que los sprites (del orden de uno por celda)
+    float worldWidth = width * BLOCK_SIZE, worldHeight = height * BLOCK_SIZE;
+    float cellSize = std::max(SPRITE_GRID_CELL, sqrtf(worldWidth * worldHeight / std::max((int)list.size(), 1)));
+    sprites.BuildGrid(worldWidth, worldHeight, cellSize);
+    spriteVersion++;
+}
+
+// Ruta del archivo de un nivel numerado
+inline std::string LevelPath(int levelNumber) {
+    return "levels/level" + std::to_string(levelNumber) + ".lvl";
+}
+
+// Deja un nivel ya abierto como mapa actual. El mapa se usa directo desde
+// el archivo mapeado, asi que el tiempo no depende del tamaño.
+inline void UseLevel(LevelFile&& level, Player& player) {
+    worldLevel = std::move(level);
+    worldMap = worldLevel.cells;
+    mapWidth = (int)worldLevel.header->width;
+    mapHeight = (int)worldLevel.header->height;
+    sceneVersion++;
+    
+    if (worldLevel.emptySpace != nullptr) {
+        emptySpace = worldLevel.emptySpace;
+        emptySpaceStorage.clear();
+    } else {
+        emptySpaceStorage.assign(LevelCellsBytes(mapWidth, mapHeight), 0);
+        BuildEmptySpaceField(worldMap, mapWidth, mapHeight, emptySpaceStorage.data());
+        emptySpace = emptySpaceStorage.data();
+    }
+    emptySpaceSkipping = worldLevel.skipEmptySpace;
+    
+    // Hornear la luz del nivel; las luces atraviesan la grilla sin
+    // importar si el salto de espacio vacio esta activo
+    if (worldLevel.lightCount > 0 || worldLevel.ambientLight < LIGHT_FULL) {
+        std::vector<PointLight> lights;
+        for (uint32_t i = 0; i < worldLevel.lightCount; i++) {
+            const LevelLight& light = worldLevel.lights[i];
+            lights.push_back({light.x, light.y, light.radius, light.intensity});
+        }
+        lightGrid.Bake({worldMap, mapWidth, mapHeight, emptySpace}, (int)worldLevel.ambientLight, lights);
+    } else {
+        lightGrid.Clear();
+    }
+    
+    // El PVS se usa directo desde el archivo; si no es valido no se usa
+    if (worldLevel.pvs == nullptr || !worldPvs.Load(worldLevel.pvs, worldLevel.pvsSize, mapWidth, mapHeight)) worldPvs.Clear();
+    
+    std::vector<Sprite> levelSprites;
+    levelSprites.reserve(worldLevel.header->spriteCount);
+    for (uint32_t i = 0; i < worldLevel.header->spriteCount; i++) {
+        const LevelSprite& sprite = worldLevel.sprites[i];
+        levelSprites.push_back({BLOCK_SIZE * sprite.x, BLOCK_SIZE * sprite.y, sprite.type});
+    }
+    SetSprites(levelSprites, mapWidth, mapHeight);
+    
+    player.x = BLOCK_SIZE * worldLevel.header->spawnX;
+    player.y = BLOCK_SIZE * worldLevel.header->spawnY;
+    player.angle = worldLevel.header->spawnAngle;
+    player.hasWon = false;
+}
+
+// Abre un archivo de nivel y lo deja como mapa actual
+inline bool LoadLevelFile(const char* path, Player& player, std::string* error = nullptr) {
+    LevelFile level;
+    if (!OpenLevelFile(path, level, error)) return false;
+    UseLevel(std::move(level), player);
+    return true;
+}
+
+// Carga el nivel desde el paquete de assets o, si no esta ahi, desde su
+// archivo suelto
+inline bool LoadLevel(int levelNumber, Player& player, std::string* error = nullptr) {
+    std::string path = LevelPath(levelNumber);
+    LevelFile level;
+    const BundleEntry* entry = assetBundle.Find(path.c_str(), BUNDLE_LEVEL);
+    bool ok = entry != nullptr ? OpenLevelFileRange(assetBundle.Path().c_str(), entry->offset, entry->size, level, error)
+                               : OpenLevelFile(path.c_str(), level, error);
+    if (!ok) return false;
+    UseLevel(std::move(level), player);
+    currentLevel = levelNumber;
+    return true;
+}
+
+inline Color* CreateCubeTexture(Color cubeColor) {
+    Color* texture = new Color[SPRITE_SIZE * SPRITE_SIZE];
+    
+    for (int y = 0; y < SPRITE_SIZE; y++) {
+        for (int x = 0; x < SPRITE_SIZE; x++) {
+            // Crear un cubo simple con bordes mas oscuros
+            if (x < 2 || x >= SPRITE_SIZE-2 || y < 2 || y >= SPRITE_SIZE-2) {
+                // Bordes oscuros
+                texture[y * SPRITE_SIZE + x] = {
+                    (unsigned char)(cubeColor.r * 0.3f),
+                    (unsigned char)(cubeColor.g * 0.3f),
+                    (unsigned char)(cubeColor.b * 0.3f),
+                    255
+                };
+            } else if (x < 4 || x >= SPRITE_SIZE-4 || y < 4 || y >= SPRITE_SIZE-4) {
+                // Bordes medios
+                texture[y * SPRITE_SIZE + x] = {
+                    (unsigned char)(cubeColor.r * 0.7f),
+                    (unsigned char)(cubeColor.g * 0.7f),
+                    (unsigned char)(cubeColor.b * 0.7f),
+                    255
+                };
+            } else {
+                // Centro del cubo
+                texture[y * SPRITE_SIZE + x] = cubeColor;
+            }
+        }
+    }
+    
+    return texture;
+}
+
+// Texturas de cubo del juego: nombre en el paquete de assets y color con
+// que se genera si no esta ahi
+struct CubeTextureInfo {
+    const char* name;
+    Color color;
+};
+
+inline const CubeTextureInfo WALL_TEXTURES[5] = {
+    {"textures/wall0", WHITE}, {"textures/wall1", RED}, {"textures/wall2", BLUE},
+    {"textures/wall3", GREEN}, {"textures/wall4", PURPLE}
+};
+inline const CubeTextureInfo FLOOR_TEXTURE = {"textures/floor", DARKGRAY};
+inline const CubeTextureInfo CEILING_TEXTURE = {"textures/ceiling", DARKBLUE};
+inline const CubeTextureInfo SPRITE_TEXTURES[LEVEL_SPRITE_TYPES] = {
+    {"textures/sprite0", SKYBLUE}, {"textures/sprite1", LIME}, {"textures/sprite2", ORANGE}
+};
+
+// Llama a use con los pixeles de la textura: la horneada en el paquete de
+// assets o, si no esta, la generada con CreateCubeTexture
+template <class Use>
+inline void WithCubeTexture(const CubeTextureInfo& info, Use use) {
+    const Color* baked = assetBundle.Texture(info.name, SPRITE_SIZE);
+    if (baked != nullptr) {
+        use(baked);
+        return;
+    }
+    Color* texture = CreateCubeTexture(info.color);
+    use(texture);
+    delete[] texture;
+}
+
+// Texturas de sprites (ver sprite_texture.h)
+inline SpriteTexture spriteTextures[LEVEL_SPRITE_TYPES];
+
+// Texturas de pared: wallTextureIds[celda] es el id en wallAtlas para las
+// celdas 1 a 4; el 0 es la textura de cualquier otro valor. El piso y el
+// techo usan el mismo atlas.
+inline TextureAtlas wallAtlas;
+inline int wallTextureIds[5];
+inline int floorTextureId;
+inline int ceilingTextureId;
+
+// Prepara las texturas de los sprites: cubo azul, verde y naranja
+inline void CreateSpriteTextures() {
+    for (int i = 0; i < LEVEL_SPRITE_TYPES; i++) {
+        WithCubeTexture(SPRITE_TEXTURES[i], [i](const Color* texture) {
+            spriteTextures[i] = BuildSpriteTexture(texture, SPRITE_SIZE);
+        });
+    }
+    spriteVersion++;
+}
+
+// Arma el atlas de paredes con las mismas texturas de los cubos
+inline void CreateWallTextures() {
+    wallAtlas = TextureAtlas();
+    for (int i = 0; i < 5; i++) {
+        WithCubeTexture(WALL_TEXTURES[i], [i](const Color* texture) {
+            wallTextureIds[i] = wallAtlas.Add(texture, SPRITE_SIZE);
+        });
+    }
+    
+    WithCubeTexture(FLOOR_TEXTURE, [](const Color* texture) { floorTextureId = wallAtlas.Add(texture, SPRITE_SIZE); });
+    WithCubeTexture(CEILING_TEXTURE, [](const Color* texture) { ceilingTextureId = wallAtlas.Add(texture, SPRITE_SIZE); });
+    sceneVersion++;
+}
+
+inline bool IsWall(float x, float y) {
+    int mapX = (int)x;
+    int mapY = (int)y;
+    
+    if (mapX < 0 || mapX >= mapWidth || mapY < 0 || mapY >= mapHeight) {
+        return true;
+    }
+    
+    return worldMap[mapY * mapWidth + mapX] == 1;
+}
+
+// Llena las tablas por columna para width columnas y el FOV dado
+inline void BuildColumnTables(ColumnTables& tables, int width, float fov) {
+    tables.width = width;
+    tables.fov = fov;
+    tables.cameraX.resize(width);
+    tables.invLength.resize(width);
+    tables.angle.resize(width);
+    // tan en double: el resultado no depende de si el compilador la evalua
+    // en tiempo de compilacion (tanf de la libm puede diferir en el ultimo bit)
+    float planeLength = (float)tan(fov / 2.0);
+    for (int x = 0; x < width; x++) {
+        float cameraX = 2.0f * x / width - 1.0f;
+        float planeOffset = planeLength * cameraX;
+        tables.cameraX[x] = cameraX;
+        tables.invLength[x] = 1.0f / sqrtf(1.0f + planeOffset * planeOffset);
+        tables.angle[x] = atanf(planeOffset);
+    }
+}
+
+// Reconstruye las tablas del juego si cambio la resolucion o el FOV
+inline void UpdateColumnTables(int width, float fov) {
+    if (columnTables.width == width && columnTables.fov == fov) return;
+    BuildColumnTables(columnTables, width, fov);
+}
+
+inline Camera SetupCamera(const Player& player, float fov) {
+    Camera camera;
+    camera.x = player.x;
+    camera.y = player.y;
+    camera.dirX = cosf(player.angle);
+    camera.dirY = sinf(player.angle);
+    float planeLength = (float)tan(fov / 2.0);  // Igual que en BuildColumnTables
+    camera.planeX = -camera.dirY * planeLength;
+    camera.planeY = camera.dirX * planeLength;
+    return camera;
+}
+
+// Direcciones unitarias de los rayos de las columnas [startX, startX + count)
+inline void CameraRays(const ColumnTables& tables, const Camera& camera, int startX, int count, float* dirX, float* dirY) {
+    const float* cameraX = tables.cameraX.data() + startX;
+    const float* invLength = tables.invLength.data() + startX;
+    for (int i = 0; i < count; i++) {
+        dirX[i] = (camera.dirX + camera.planeX * cameraX[i]) * invLength[i];
+        dirY[i] = (camera.dirY + camera.planeY * cameraX[i]) * invLength[i];
+    }
+}
+
+inline void CameraRays(const Camera& camera, int startX, int count, float* dirX, float* dirY) {
+    CameraRays(columnTables, camera, startX, count, dirX, dirY);
+}
+
+inline MapView CurrentMapView() {
+    return {worldMap, mapWidth, mapHeight, emptySpaceSkipping ? emptySpace : nullptr, lightGrid.Data(),
+            worldPvs.IsLoaded() ? &worldPvs : nullptr};
+}
+
+// Cambia una celda del mapa actual (por ejemplo al recoger el objetivo) y
+// actualiza solo la parte afectada del campo de espacio vacio, de la luz y
+// del PVS
+inline void SetMapCell(int x, int y, uint8_t value) {
+    if (x < 0 || x >= mapWidth || y < 0 || y >= mapHeight) return;
+    if (worldMap[y * mapWidth + x] == value) return;
+    worldMap[y * mapWidth + x] = value;
+    sceneVersion++;
+    UpdateEmptySpaceField(worldMap, mapWidth, mapHeight, emptySpace, x, y);
+    lightGrid.UpdateCell({worldMap, mapWidth, mapHeight, emptySpace}, x, y);
+    worldPvs.UpdateCell({worldMap, mapWidth, mapHeight, emptySpace}, x, y);
+}
+
+// Luces dinamicas del mapa actual (solo en niveles con iluminacion):
+// moverlas recalcula las celdas que alcanzan, no todo el mapa
+inline int AddDynamicLight(const PointLight& light) {
+    if (!lightGrid.IsLit()) return -1;
+    sceneVersion++;
+    return lightGrid.AddLight({worldMap, mapWidth, mapHeight, emptySpace}, light);
+}
+
+inline void MoveDynamicLight(int id, float x, float y) {
+    if (id < 0) return;
+    sceneVersion++;
+    lightGrid.MoveLight({worldMap, mapWidth, mapHeight, emptySpace}, id, x, y);
+}
+
+// Escribe la parte visible de una columna de pared texturizada sobre el
+// piso y techo ya pintados. wallTop puede quedar fuera de la pantalla; la
+// textura se recorre en punto fijo 16.16 sobre una columna contigua del atlas
+// y el brillo se aplica con su fila de ShadeTable.
+inline void DrawWallColumn(const RenderTarget& target, int x, float wallTop, float wallHeight, const Color* texColumn, int texSize, int brightness) {
+    int drawStart = std::max((int)ceilf(wallTop), 0);
+    int drawEnd = std::min((int)ceilf(wallTop + wallHeight), target.height);
+    if (drawStart >= drawEnd) return;
+    
+    uint32_t step = (uint32_t)(texSize * 65536.0f / wallHeight);
+    uint32_t texPos = (uint32_t)((drawStart - wallTop) * texSize * 65536.0f / wallHeight);
+    uint32_t texMax = (uint32_t)texSize - 1;
+    const uint8_t* shade = ShadeTable()[brightness];
+    Color* pixel = target.pixels + drawStart * target.width + x;
+    for (int y = drawStart; y < drawEnd; y++, pixel += target.width, texPos += step) {
+        Color color = texColumn[std::min(texPos >> 16, texMax)];
+        *pixel = {shade[color.r], shade[color.g], shade[color.b], color.a};
+    }
+}
+
+// Pinta el piso (mitad de abajo) y el techo (mitad de arriba) de las filas
+// [startY, endY). En cada fila la distancia es fija: la posicion en el mundo
+// se interpola en linea recta entre los rayos de los bordes de la pantalla
+// y el sombreado usa la misma caida con la distancia que las paredes, por
+// la luz de cada celda si el mapa tiene iluminacion.
+inline void RenderFloorRows(const Camera& camera, const MapView& map, const RenderTarget& target, int startY, int endY) {
+    for (int y = startY; y < endY; y++) {
+        bool isFloor = y >= target.height / 2;
+        float rowOffset = isFloor ? y + 0.5f - target.height / 2 : target.height / 2 - y - 0.5f;
+        
+        // Una pared a esta distancia tendria su borde justo en esta fila
+        float distance = (target.height * BLOCK_SIZE / 2) / rowOffset;
+        
+        // Posicion en el mundo de la columna 0 y avance por columna
+        float worldX = camera.x + distance * (camera.dirX - camera.planeX);
+        float worldY = camera.y + distance * (camera.dirY - camera.planeY);
+        float stepX = distance * 2 * camera.planeX / target.width;
+        float stepY = distance * 2 * camera.planeY / target.width;
+        
+        // Mipmap segun cuantos pixeles ocupa una celda a esta distancia
+        int texture = isFloor ? floorTextureId : ceilingTextureId;
+        int level = wallAtlas.SelectLevel(texture, BLOCK_SIZE / sqrtf(stepX * stepX + stepY * stepY));
+        int texSize = wallAtlas.LevelSize(texture, level);
+        float texScale = texSize / BLOCK_SIZE;
+        
+        FloorRow row;
+        row.u = worldX * texScale;
+        row.v = worldY * texScale;
+        row.stepU = stepX * texScale;
+        row.stepV = stepY * texScale;
+        row.texels = wallAtlas.Column(texture, level, 0);
+        row.texSize = texSize;
+        row.brightness = (int)(255 / (1 + distance * 0.01f));
+        row.light = map.light;
+        row.mapWidth = map.width;
+        row.mapHeight = map.height;
+        DrawFloorRow(row, target.pixels + y * target.width, target.width, rayKernel);
+    }
+}
+
+// Sprite ya proyectado a la pantalla para el frame actual
+struct SpriteProjection {
+    float depth;        // Profundidad en el espacio de la camara
+    int screenX;        // Columna del centro del sprite
+    int size;           // Alto y ancho en pixeles
+    int drawStartX, drawEndX;
+    int type;
+    int light;          // Luz de la celda del sprite (LIGHT_FULL sin iluminacion)
+};
+
+// Proyeccion del frame actual por sprite, y los visibles del frame del mas
+// lejano al mas cercano
+inline std::vector<SpriteProjection> spriteProjections;
+inline std::vector<SpriteProjection> visibleSprites;
+
+// Proyecta el sprite i de set en target; devuelve false si no cae en pantalla
+inline bool ProjectSprite(const Camera& camera, const SpriteSet& set, int i, const RenderTarget& target, SpriteProjection& out) {
+    // Calcular vector de la camara al sprite
+    float spriteX = set.x[i] - camera.x;
+    float spriteY = set.y[i] - camera.y;
+    
+    // Transformar coordenadas del sprite al espacio de la cámara
+    // (inversa de la matriz [plane dir]); transformY es la profundidad
+    float invDet = 1.0f / (camera.planeX * camera.dirY - camera.dirX * camera.planeY);
+    float transformX = invDet * (camera.dirY * spriteX - camera.dirX * spriteY);
+    float transformY = invDet * (-camera.planeY * spriteX + camera.planeX * spriteY);
+    
+    // Si el sprite está detrás del jugador, no dibujarlo
+    if (transformY <= 0) return false;
+    
+    // Calcular posición en pantalla
+    out.depth = transformY;
+    out.screenX = (int)((target.width / 2) * (1 + transformX / transformY));
+    out.size = abs((int)(target.height * SPRITE_WORLD_SIZE / transformY));
+    out.type = set.type[i];
+    out.light = LIGHT_FULL;
+    
+    out.drawStartX = -out.size / 2 + out.screenX;
+    if (out.drawStartX < 0) out.drawStartX = 0;
+    out.drawEndX = out.size / 2 + out.screenX;
+    if (out.drawEndX >= target.width) out.drawEndX = target.width - 1;
+    return out.drawStartX < out.drawEndX;
+}
+
+// Dibuja solo las columnas [clipStartX, clipEndX) del sprite, para que cada
+// tile del renderizador paralelo pinte su propia franja de pantalla. Por
+// columna recorre solo los tramos opacos de la textura, con la fila en punto
+// fijo 16.16 y el sombreado por distancia y luz en una fila de ShadeTable.
+inline void DrawSprite(const RenderTarget& target, const SpriteProjection& sprite, const SpriteTexture& texture, int clipStartX, int clipEndX) {
+    int spriteHeight = sprite.size;
+    int spriteWidth = sprite.size;
+    if (spriteHeight <= 0) return;
+    
+    // Calcular límites de dibujo
+    int spriteTop = -spriteHeight / 2 + target.height / 2;
+    int spriteLeft = -spriteWidth / 2 + sprite.screenX;
+    int drawStartY = std::max(spriteTop, 0);
+    int drawEndY = std::min(spriteHeight / 2 + target.height / 2, target.height - 1);
+    
+    int drawStartX = std::max(sprite.drawStartX, clipStartX);
+    int drawEndX = std::min(sprite.drawEndX, clipEndX);
+    
+    // Sombreado por distancia y luz, igual para todo el sprite
+    int brightness = (int)(255 / (1 + sprite.depth * 0.01f));
+    const uint8_t* shade = ShadeTable()[ShadeTable()[brightness][sprite.light]];
+    
+    int texSize = texture.size;
+    int64_t scale = (int64_t)texSize << 16;
+    uint32_t step = (uint32_t)((scale + spriteHeight - 1) / spriteHeight);
+    
+    for (int stripe = drawStartX; stripe < drawEndX; stripe++) {
+        // Saltar de una vez los bloques de columnas donde la pared tapa todo
+        if (stripe == drawStartX || stripe % DEPTH_PYRAMID_BLOCK == 0) {
+            if (sprite.depth >= target.pyramid->BlockMax(0, stripe / DEPTH_PYRAMID_BLOCK)) {
+                stripe = (stripe / DEPTH_PYRAMID_BLOCK + 1) * DEPTH_PYRAMID_BLOCK - 1;
+                continue;
+            }
+        }
+        
+        // Solo dibujar si el sprite está más cerca que la pared
+        if (sprite.depth >= target.depth[stripe]) continue;
+        
+        int texX = (stripe - spriteLeft) * texSize / spriteWidth;
+        if (texX < 0 || texX >= texSize) continue;
+        const Color* column = texture.Column(texX);
+        
+        for (int k = texture.columnSpans[texX]; k < texture.columnSpans[texX + 1]; k++) {
+            const SpriteSpan& span = texture.spans[k];
+            
+            // Filas de pantalla que caen en el tramo [span.start, span.end)
+            int y0 = spriteTop + (int)(((int64_t)span.start * spriteHeight + texSize - 1) / texSize);
+            int y1 = spriteTop + (int)(((int64_t)span.end * spriteHeight + texSize - 1) / texSize);
+            y0 = std::max(y0, drawStartY);
+            y1 = std::min(y1, drawEndY);
+            if (y0 >= y1) continue;
+            
+            // Posicion redondeada hacia arriba para no caer antes del tramo
+            uint32_t texPos = (uint32_t)(((int64_t)(y0 - spriteTop) * scale + spriteHeight - 1) / spriteHeight);
+            uint32_t last = span.end - 1;
+            Color* pixel = target.pixels + y0 * target.width + stripe;
+            for (int y = y0; y < y1; y++, pixel += target.width, texPos += step) {
+                Color color = column[std::min(texPos >> 16, last)];
+                *pixel = {shade[color.r], shade[color.g], shade[color.b], color.a};
+            }
+            if (target.pixelDepth != nullptr) {
+                float* depth = target.pixelDepth + y0 * target.width + stripe;
+                for (int y = y0; y < y1; y++, depth += target.width) *depth = sprite.depth;
+            }
+        }
+    }
+}
+
+// Frame anterior, para reusarlo en RenderScene
+struct FrameHistory {
+    bool valid = false;
+    float x, y, angle;
+    const uint8_t* cells;
+    int mapWidth, mapHeight;
+    uint32_t sceneVersion, spriteVersion;
+    int width, height;
+    
+    // Piso, techo y paredes sin sprites de la ultima camara quieta
+    std::vector<Color> wallLayer;
+    bool wallLayerValid = false;
+    
+    // Caras golpeadas por columna (ver column_reuse.h): faces[current] es la
+    // del ultimo frame con paredes, la otra se llena en el siguiente
+    std::vector<ColumnFace> faces[2];
+    int current = 0;
+};
+
+inline FrameHistory frameHistory;
+
+// Caras por columna para reusar rayos al girar: las del frame anterior
+// (previous, nullptr si la camara se movio) y donde guardar las de este
+// (current, nullptr si no se van a reusar)
+struct ColumnReuse {
+    const ColumnFace* previous;
+    float turn;             // Angulo girado desde el frame anterior
+    ColumnFace* current;
+};
+
+// Renderiza las paredes de las columnas [startX, endX) y llena el buffer de
+// profundidad de esas mismas columnas. Cada columna solo depende de si
+// misma, asi que distintos rangos se pueden renderizar en paralelo.
+inline void RenderColumns(const Camera& camera, const MapView& map, const RenderTarget& target, int startX, int endX, const ColumnReuse& reuse) {
+    // Entradas y salidas del lote de rayos de este tile
+    float dirX[TILE_WIDTH], dirY[TILE_WIDTH];
+    float distance[TILE_WIDTH], wallHeight[TILE_WIDTH], wallX[TILE_WIDTH];
+    int brightness[TILE_WIDTH], cell[TILE_WIDTH], side[TILE_WIDTH];
+    
+    int count = endX - startX;
+    CameraRays(*target.columns, camera, startX, count, dirX, dirY);
+    
+    const float* fisheye = target.columns->invLength.data() + startX;
+    RayBatch batch = {camera.x, camera.y, dirX, dirY, fisheye, count};
+    WallHits hits = {distance, wallHeight, brightness, cell, side, wallX};
+    
+    // Las columnas que caen entre dos del frame anterior con la misma cara
+    // se rehacen con esa cara; las demas se juntan en un lote y se lanzan
+    int castColumns[TILE_WIDTH];
+    int castCount = count;
+    if (reuse.previous != nullptr) {
+        const std::vector<float>& angle = target.columns->angle;
+        castCount = 0;
+        for (int i = 0; i < count; i++) {
+            float targetAngle = angle[startX + i] + reuse.turn;
+            int old = (int)(std::upper_bound(angle.begin(), angle.end(), targetAngle) - angle.begin()) - 1;
+            Intersect hit;
+            if (old >= 0 && old + 1 < target.width &&
+                ReprojectHit(map, camera.x, camera.y, dirX[i], dirY[i], BLOCK_SIZE, reuse.previous[old], reuse.previous[old + 1],
+                             angle[old + 1] - angle[old], hit)) {
+                ShadeColumnScalar(batch, hit, BLOCK_SIZE, target.height, hits, i);
+            } else {
+                castColumns[castCount++] = i;
+            }
+        }
+    }
+    
+    if (castCount == count) {
+        CastRays(map, batch, BLOCK_SIZE, target.height, hits, rayKernel);
+    } else if (castCount > 0) {
+        float castDirX[TILE_WIDTH], castDirY[TILE_WIDTH], castFisheye[TILE_WIDTH];
+        float castDistance[TILE_WIDTH], castHeight[TILE_WIDTH], castWallX[TILE_WIDTH];
+        int castBrightness[TILE_WIDTH], castCell[TILE_WIDTH], castSide[TILE_WIDTH];
+        for (int k = 0; k < castCount; k++) {
+            int i = castColumns[k];
+            castDirX[k] = dirX[i];
+            castDirY[k] = dirY[i];
+            castFisheye[k] = fisheye[i];
+        }
+        RayBatch castBatch = {camera.x, camera.y, castDirX, castDirY, castFisheye, castCount};
+        WallHits castHits = {castDistance, castHeight, castBrightness, castCell, castSide, castWallX};
+        CastRays(map, castBatch, BLOCK_SIZE, target.height, castHits, rayKernel);
+        for (int k = 0; k < castCount; k++) {
+            int i = castColumns[k];
+            distance[i] = castDistance[k];
+            wallHeight[i] = castHeight[k];
+            brightness[i] = castBrightness[k];
+            cell[i] = castCell[k];
+            side[i] = castSide[k];
+            wallX[i] = castWallX[k];
+        }
+    }
+    
+    // Luz de la celda frente a cada cara golpeada
+    if (map.light != nullptr) {
+        const uint8_t (*shadeTable)[256] = ShadeTable();
+        for (int i = 0; i < count; i++) {
+            float rayDistance = distance[i] / fisheye[i] / BLOCK_SIZE;
+            int light = WallLight(map, camera.x / BLOCK_SIZE, camera.y / BLOCK_SIZE, dirX[i], dirY[i], rayDistance, side[i]);
+            brightness[i] = shadeTable[brightness[i]][light];
+        }
+    }
+    
+    for (int i = 0; i < count; i++) {
+        int x = startX + i;
+        
+        // Guardar distancia en buffer de profundidad
+        target.depth[x] = distance[i];
+        
+        // Cara golpeada, para reusar el rayo en el frame siguiente
+        if (reuse.current != nullptr) {
+            float rayDistance = distance[i] / fisheye[i] / BLOCK_SIZE;
+            reuse.current[x] = FaceOfHit(camera.x / BLOCK_SIZE, camera.y / BLOCK_SIZE, dirX[i], dirY[i], rayDistance, side[i]);
+        }
+        
+        // Textura segun la celda, nivel de mipmap segun la altura en pantalla
+        int texture = wallTextureIds[cell[i] >= 1 && cell[i] <= 4 ? cell[i] : 0];
+        int level = wallAtlas.SelectLevel(texture, wallHeight[i]);
+        int texSize = wallAtlas.LevelSize(texture, level);
+        int texX = std::min((int)(wallX[i] * texSize), texSize - 1);
+        
+        // Limitar la altura para que una pared pegada a la camara no desborde el punto fijo
+        float height = std::min(wallHeight[i], 1024.0f * target.height);
+        float wallTop = (target.height - height) / 2;
+        DrawWallColumn(target, x, wallTop, height, wallAtlas.Column(texture, level, texX), texSize, brightness[i]);
+    }
+    
+    target.pyramid->BuildSpan(startX, endX);
+}
+
+// Llama a visit(i, projection, occluded) para cada sprite activo de set que
+// cae en pantalla en target; occluded si las paredes ya dibujadas lo tapan
+// por completo. Solo recorre las celdas de la grilla que toca el cono de
+// vision, cortado a la pared mas lejana. La luz de cada sprite sale de map.
+// Si map tiene PVS, solo pasan los sprites de celdas visibles desde la de
+// la camara y el cono se corta tambien a la distancia maxima visible.
+template <class Visit>
+inline void ForEachSpriteInView(const Camera& camera, const MapView& map, const SpriteSet& set, const RenderTarget& target, Visit visit) {
+    float farthest = target.pyramid->ScreenMax();
+    const PvsCell* visibleCells = nullptr;
+    if (map.pvs != nullptr) {
+        visibleCells = map.pvs->Lookup((int)floorf(camera.x / BLOCK_SIZE), (int)floorf(camera.y / BLOCK_SIZE));
+        if (visibleCells != nullptr) farthest = std::min(farthest, visibleCells->maxDistance * BLOCK_SIZE);
+    }
+    
+    // Triangulo del cono: la camara y los extremos del plano a la distancia
+    // de la pared mas lejana (la profundidad se mide sobre dir)
+    float reach = farthest + SPRITE_WORLD_SIZE;
+    float cornerX[3] = {camera.x, camera.x + (camera.dirX - camera.planeX) * reach, camera.x + (camera.dirX + camera.planeX) * reach};
+    float cornerY[3] = {camera.y, camera.y + (camera.dirY - camera.planeY) * reach, camera.y + (camera.dirY + camera.planeY) * reach};
+    
+    set.ForEachInTriangle(cornerX, cornerY, SPRITE_WORLD_SIZE, [&](int i) {
+        int cellX = (int)floorf(set.x[i] / BLOCK_SIZE), cellY = (int)floorf(set.y[i] / BLOCK_SIZE);
+        if (visibleCells != nullptr && !visibleCells->Contains(cellX, cellY)) return;
+        SpriteProjection projection;
+        if (!set.active[i] || !ProjectSprite(camera, set, i, target, projection)) return;
+        projection.light = LightAt(map, cellX, cellY);
+        
+        // Primero una sola lectura del bloque que cubre al sprite; si no
+        // alcanza, el maximo exacto de sus columnas
+        int startX = projection.drawStartX, endX = projection.drawEndX;
+        bool occluded = projection.depth >= target.pyramid->CoarseMax(startX, endX) ||
+                        projection.depth >= target.pyramid->SpanMax(startX, endX);
+        visit(i, projection, occluded);
+    });
+}
+
+// Junta en visibleSprites los sprites que caen en pantalla y que las
+// paredes no tapan por completo, ordenados del mas lejano al mas cercano
+inline void CollectVisibleSprites(const Camera& camera, const MapView& map) {
+    spriteStats = SpriteStats();
+    spriteProjections.resize(sprites.Count());
+    ForEachSpriteInView(camera, map, sprites, MainRenderTarget(), [](int i, const SpriteProjection& projection, bool occluded) {
+        spriteStats.inView++;
+        if (occluded) {
+            spriteStats.occluded++;
+            return;
+        }
+        spriteProjections[i] = projection;
+        sprites.MarkVisible(i, projection.depth);
+    });
+    
+    const std::vector<int>& order = sprites.SortVisible();
+    spriteStats.drawn = (int)order.size();
+    visibleSprites.clear();
+    for (int i : order) visibleSprites.push_back(spriteProjections[i]);
+}
+
+// Renderiza la vista 3D completa en el framebuffer con los hilos de
+// renderPool: primero piso y techo por bandas de filas, despues paredes y
+// sprites visibles en tiles de TILE_WIDTH columnas. Cada pixel lo escribe
+// una sola tarea en cada pasada, asi que el resultado es determinista.
+//
+// Con temporalReuse se aprovecha el frame anterior sin cambiar la imagen:
+// si nada cambio no se dibuja nada (devuelve false y el framebuffer queda
+// como estaba); si solo cambiaron los sprites se reponen piso, techo y
+// paredes guardados y se dibujan los sprites encima; si la camara solo
+// giro, las columnas que ven la misma cara que en el frame anterior no
+// recorren la grilla (ver column_reuse.h).
+inline bool RenderScene(const Player& player, const MapView& map) {
+    FrameHistory& history = frameHistory;
+    bool sameScene = temporalReuse && history.valid && history.cells == map.cells && history.mapWidth == map.width &&
+                     history.mapHeight == map.height && history.sceneVersion == sceneVersion &&
+                     history.width == renderWidth && history.height == renderHeight;
+    bool samePosition = sameScene && history.x == player.x && history.y == player.y;
+    bool sameCamera = samePosition && history.angle == player.angle;
+    bool sameSprites = history.spriteVersion == spriteVersion;
+    if (sameCamera && sameSprites) return false;
+    
+    float turn = remainderf(player.angle - history.angle, 2 * PI);
+    history.valid = true;
+    history.x = player.x;
+    history.y = player.y;
+    history.angle = player.angle;
+    history.cells = map.cells;
+    history.mapWidth = map.width;
+    history.mapHeight = map.height;
+    history.sceneVersion = sceneVersion;
+    history.spriteVersion = spriteVersion;
+    history.width = renderWidth;
+    history.height = renderHeight;
+    
+    UpdateColumnTables(renderWidth, FOV);
+    Camera camera = SetupCamera(player, FOV);
+    RenderTarget target = MainRenderTarget();
+    int numTiles = (renderWidth + TILE_WIDTH - 1) / TILE_WIDTH;
+    
+    if (sameCamera && history.wallLayerValid) {
+        // Solo cambiaron los sprites: el buffer de profundidad y su piramide
+        // siguen valiendo
+        PROFILE_SCOPE("reponer paredes");
+        std::copy(history.wallLayer.begin(), history.wallLayer.end(), frameBuffer);
+    } else {
+        depthPyramid.Attach(depthBuffer, renderWidth);
+        
+        // Piso y techo por bandas de filas; las paredes y sprites van encima
+        int numBands = (renderHeight + FLOOR_BAND_HEIGHT - 1) / FLOOR_BAND_HEIGHT;
+        renderPool->ParallelFor(numBands, [&](int band) {
+            PROFILE_SCOPE("piso y techo");
+            int startY = band * FLOOR_BAND_HEIGHT;
+            RenderFloorRows(camera, map, target, startY, std::min(startY + FLOOR_BAND_HEIGHT, renderHeight));
+        });
+        
+        std::vector<ColumnFace>& faces = history.faces[1 - history.current];
+        faces.resize(renderWidth);
+        ColumnReuse reuse = {samePosition ? history.faces[history.current].data() : nullptr, turn, faces.data()};
+        renderPool->ParallelFor(numTiles, [&](int tile) {
+            PROFILE_SCOPE("paredes");
+            int startX = tile * TILE_WIDTH;
+            int endX = std::min(startX + TILE_WIDTH, renderWidth);
+            RenderColumns(camera, map, target, startX, endX, reuse);
+        });
+        depthPyramid.Finish(TILE_WIDTH);
+        history.current = 1 - history.current;
+        
+        // Con la camara quieta es probable que siga asi: guardar la capa sin
+        // sprites para los frames en que solo cambien los sprites
+        history.wallLayerValid = sameCamera;
+        if (sameCamera) history.wallLayer.assign(frameBuffer, frameBuffer + renderWidth * renderHeight);
+    }
+    
+    {
+        PROFILE_SCOPE("sprites: culling y orden");
+        CollectVisibleSprites(camera, map);
+    }
+    if (visibleSprites.empty()) return true;
+    renderPool->ParallelFor(numTiles, [&](int tile) {
+        PROFILE_SCOPE("sprites: dibujo");
+        int startX = tile * TILE_WIDTH;
+        int endX = std::min(startX + TILE_WIDTH, renderWidth);
+        for (const SpriteProjection& sprite : visibleSprites) {
+            if (sprite.drawEndX > startX && sprite.drawStartX < endX) {
+                DrawSprite(target, sprite, spriteTextures[sprite.type], startX, endX);
+            }
+        }
+    });
+    return true;
+}
+
+// Resolucion interna de la vista 3D como fraccion de la ventana. El ancho
+// se redondea a multiplos de 8 (un bloque de la piramide de profundidad y
+// un paso del kernel AVX2 de piso) y el alto a pares (horizonte centrado).
+// frameBuffer y depthBuffer ya tienen lugar para la resolucion completa.
+inline void SetRenderResolution(float scale) {
+    renderWidth = std::clamp((int)lroundf(SCREEN_WIDTH * scale / 8) * 8, 8, SCREEN_WIDTH);
+    renderHeight = std::clamp((int)lroundf(SCREEN_HEIGHT * scale / 2) * 2, 2, SCREEN_HEIGHT);
+}
+
+// Numero de hilos de render: "--threads N" en la linea de comandos o la
+// variable de entorno RAYCASTER_THREADS; por defecto todos los nucleos
+inline int ParseThreadCount(int argc, char** argv) {
+    int threads = (int)std::thread::hardware_concurrency();
+    const char* env = getenv("RAYCASTER_THREADS");
+    if (env != NULL) threads = atoi(env);
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0) threads = atoi(argv[i + 1]);
+    }
+    return threads < 1 ? 1 : threads;
+}
+
+// Kernel de rayos: "--ray-kernel scalar|sse|avx2"; por defecto el mejor disponible
+inline RayKernel ParseRayKernel(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--ray-kernel") == 0) {
+            if (strcmp(argv[i + 1], "scalar") == 0) return RAY_KERNEL_SCALAR;
+            if (strcmp(argv[i + 1], "sse") == 0) return RAY_KERNEL_SSE;
+            if (strcmp(argv[i + 1], "avx2") == 0) return RAY_KERNEL_AVX2;
+        }
+    }
+    return RAY_KERNEL_AUTO;
+}
+
+// Frames por segundo: "--fps N", por defecto 60; 0 = sin limite. La
+// velocidad del juego no depende de esto (ver simulation.h).
+inline int ParseTargetFps(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--fps") == 0) return std::max(atoi(argv[i + 1]), 0);
+    }
+    return 60;
+}
+
+// Resolucion dinamica: "--target-ms N" la activa con un objetivo de N ms de
+// trabajo por frame. Devuelve 0 si no se pidio.
+inline float ParseTargetFrameMs(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--target-ms") == 0) return std::max((float)atof(argv[i + 1]), 0.0f);
+    }
+    return 0.0f;
+}
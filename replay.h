@@ -0,0 +1,190 @@
+#pragma once
+
+// Grabacion de la entrada por tick y repeticion determinista (.rpl).
+//
+// La simulacion avanza en ticks fijos (ver simulation.h) y StepPlayer solo
+// depende de la pose, la entrada del tick y el mapa, asi que basta con
+// guardar el nivel y la entrada de cada tick para repetir exactamente el
+// mismo camino. El juego no usa numeros aleatorios; el estado del nivel se
+// guarda como su numero, un hash de las celdas y la pose inicial, para
+// detectar un log grabado con otro archivo de nivel. Little-endian.
+//
+//   ReplayHeader
+//   tickCount bytes          entrada de cada tick (REPLAY_INPUT_*)
+//
+// Al repetir, el hash de la pose final tiene que coincidir con
+// finalStateHash; si no, algo cambio el comportamiento del juego.
+
+#include "raycaster.h"
+#include "simulation.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// 2: el jugador choca como un circulo y desliza (ver movement.h); los logs
+// de la version 1 ya no repiten el mismo camino
+const uint32_t REPLAY_FORMAT_VERSION = 2;
+
+// Bits del byte de entrada de un tick
+const uint8_t REPLAY_INPUT_FORWARD = 1;
+const uint8_t REPLAY_INPUT_BACK = 2;
+const uint8_t REPLAY_INPUT_LEFT = 4;
+const uint8_t REPLAY_INPUT_RIGHT = 8;
+
+struct ReplayHeader {
+    char magic[4];              // "RCRP"
+    uint32_t version;
+    int32_t level;              // Numero de nivel (LevelPath)
+    uint32_t width, height;     // Tamaño del mapa
+    uint32_t reserved;
+    uint64_t levelHash;         // HashMapCells de las celdas al empezar
+    float spawnX, spawnY;       // Pose inicial en unidades de mundo
+    float spawnAngle;
+    float tickSeconds;          // SIM_TICK_SECONDS con que se grabo
+    uint64_t tickCount;
+    uint64_t finalStateHash;    // HashPlayerState de la pose despues del ultimo tick
+};
+
+static_assert(sizeof(ReplayHeader) == 64, "ReplayHeader debe medir 64 bytes");
+
+inline uint8_t PackInput(const PlayerInput& input) {
+    return (input.forward ? REPLAY_INPUT_FORWARD : 0) | (input.back ? REPLAY_INPUT_BACK : 0) |
+           (input.turnLeft ? REPLAY_INPUT_LEFT : 0) | (input.turnRight ? REPLAY_INPUT_RIGHT : 0);
+}
+
+inline PlayerInput UnpackInput(uint8_t bits) {
+    return {(bits & REPLAY_INPUT_FORWARD) != 0, (bits & REPLAY_INPUT_BACK) != 0,
+            (bits & REPLAY_INPUT_LEFT) != 0, (bits & REPLAY_INPUT_RIGHT) != 0};
+}
+
+// FNV-1a de bytes, encadenable
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 1469598103934665603ull) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 1099511628211ull;
+    return hash;
+}
+
+inline uint64_t HashMapCells(const uint8_t* cells, int width, int height) {
+    return HashBytes(cells, (size_t)width * height);
+}
+
+// Hash de la pose exacta (bits de los floats) y de si gano
+inline uint64_t HashPlayerState(const Player& player) {
+    uint64_t hash = HashBytes(&player.x, sizeof(float));
+    hash = HashBytes(&player.y, sizeof(float), hash);
+    hash = HashBytes(&player.angle, sizeof(float), hash);
+    uint8_t won = player.hasWon ? 1 : 0;
+    return HashBytes(&won, 1, hash);
+}
+
+// Partida grabada
+struct ReplayLog {
+    ReplayHeader header;
+    std::vector<uint8_t> inputs;    // Una entrada por tick
+};
+
+// Graba la partida de un nivel, desde el hilo principal
+class InputRecorder {
+public:
+    // Empieza una partida nueva en el nivel actual, con el jugador en player
+    void Begin(int level, const Player& player) {
+        log = ReplayLog();
+        memcpy(log.header.magic, "RCRP", 4);
+        log.header.version = REPLAY_FORMAT_VERSION;
+        log.header.level = level;
+        log.header.width = (uint32_t)mapWidth;
+        log.header.height = (uint32_t)mapHeight;
+        log.header.levelHash = HashMapCells(worldMap, mapWidth, mapHeight);
+        log.header.spawnX = player.x;
+        log.header.spawnY = player.y;
+        log.header.spawnAngle = player.angle;
+        log.header.tickSeconds = SIM_TICK_SECONDS;
+        recording = true;
+    }
+
+    bool IsRecording() const { return recording; }
+
+    // Agrega los ticks de un resultado de la simulacion (SimSnapshot::ticks
+    // ticks con SimSnapshot::input)
+    void Record(const SimSnapshot& snapshot) {
+        if (recording) log.inputs.insert(log.inputs.end(), snapshot.ticks, PackInput(snapshot.input));
+    }
+
+    // Termina la partida con la pose final de la simulacion y la guarda
+    bool Finish(const Player& finalState, const char* path) {
+        if (!recording) return false;
+        recording = false;
+        log.header.tickCount = log.inputs.size();
+        log.header.finalStateHash = HashPlayerState(finalState);
+
+        FILE* file = fopen(path, "wb");
+        if (file == NULL) return false;
+        bool ok = fwrite(&log.header, sizeof(log.header), 1, file) == 1 &&
+                  (log.inputs.empty() || fwrite(log.inputs.data(), 1, log.inputs.size(), file) == log.inputs.size());
+        return fclose(file) == 0 && ok;
+    }
+
+private:
+    ReplayLog log;
+    bool recording = false;
+};
+
+inline bool ReadReplay(const char* path, ReplayLog& log, std::string* error) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        if (error) *error = std::string("no se pudo abrir ") + path;
+        return false;
+    }
+    const char* problem = NULL;
+    if (fread(&log.header, sizeof(log.header), 1, file) != 1 || memcmp(log.header.magic, "RCRP", 4) != 0) {
+        problem = "no es una grabacion";
+    } else if (log.header.version != REPLAY_FORMAT_VERSION) {
+        problem = "version de formato no soportada";
+    } else if (log.header.tickSeconds != SIM_TICK_SECONDS) {
+        problem = "grabada con otro paso de simulacion";
+    } else {
+        // Un byte por tick: tickCount no puede pasar de lo que queda del
+        // archivo (asi una cabecera corrupta no pide memoria de mas)
+        long start = ftell(file);
+        long end = start >= 0 && fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+        if (end < start || fseek(file, start, SEEK_SET) != 0 || log.header.tickCount > (uint64_t)(end - start)) {
+            problem = "replay truncado";
+        } else {
+            log.inputs.resize(log.header.tickCount);
+            if (log.header.tickCount > 0 && fread(log.inputs.data(), 1, log.inputs.size(), file) != log.inputs.size()) {
+                problem = "entradas incompletas";
+            }
+        }
+    }
+    fclose(file);
+    if (problem != NULL) {
+        if (error) *error = std::string(path) + ": " + problem;
+        return false;
+    }
+    return true;
+}
+
+// Carga el nivel de la grabacion y comprueba que sea el mismo con que se
+// grabo. Deja al jugador en la pose inicial.
+inline bool LoadReplayLevel(const ReplayLog& log, Player& player, std::string* error) {
+    if (!LoadLevel(log.header.level, player, error)) return false;
+    if ((uint32_t)mapWidth != log.header.width || (uint32_t)mapHeight != log.header.height ||
+        HashMapCells(worldMap, mapWidth, mapHeight) != log.header.levelHash) {
+        if (error) *error = "el nivel " + std::to_string(log.header.level) + " no es el mismo con que se grabo";
+        return false;
+    }
+    player.x = log.header.spawnX;
+    player.y = log.header.spawnY;
+    player.angle = log.header.spawnAngle;
+    return true;
+}
+
+// Archivo donde grabar las partidas: "--record archivo"; NULL si no se pidio
+inline const char* ParseRecordPath(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--record") == 0) return argv[i + 1];
+    }
+    return NULL;
+}
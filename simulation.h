@@ -0,0 +1,179 @@
+#pragma once
+
+// Simulacion a paso fijo, separada del render.
+//
+// El juego avanza en ticks de SIM_TICK_SECONDS sin importar cuantos frames
+// se dibujen por segundo, y el render interpola la pose entre los dos
+// ultimos ticks. Los ticks corren en un hilo propio: en cada frame el hilo
+// principal toma el resultado del trabajo lanzado en el frame anterior y
+// lanza el siguiente con la entrada y el tiempo del frame, que se simula
+// mientras el hilo principal dibuja. Es un frame de latencia a cambio de
+// usar otro nucleo.
+//
+// El hilo de simulacion no escribe el mapa: lee worldMap y su campo de
+// espacio vacio (que nadie modifica mientras corre) y devuelve los cambios
+// de celdas en el resultado, para que el hilo principal los aplique entre
+// frames. El juego no usa MovingEntities (ver movement.h; solo el
+// benchmark): sus sprites no se mueven y el render los lee sin copia. Para
+// mover sprites desde aqui habria que devolver sus posiciones en el
+// resultado y aplicarlas entre frames, igual que las celdas, porque el
+// render lee los sprites mientras corre la simulacion.
+
+#include "raycaster.h"
+#include "movement.h"
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+const float SIM_TICK_SECONDS = 1.0f / 60;
+const int SIM_MAX_TICKS_PER_FRAME = 8;  // Con frames mas lentos la simulacion se frena en vez de saltar
+
+// Teclas de movimiento de un frame, leidas en el hilo principal
+struct PlayerInput {
+    bool forward, back;
+    bool turnLeft, turnRight;
+};
+
+struct CellEdit {
+    int x, y;
+    uint8_t value;
+};
+
+// Resultado de un trabajo de simulacion
+struct SimSnapshot {
+    Player previous, current;   // Pose de los dos ultimos ticks
+    float alpha = 0.0f;         // Fraccion del tick siguiente que ya paso
+    bool won = false;           // El jugador llego al objetivo
+    std::vector<CellEdit> edits;
+    PlayerInput input = {};     // Entrada con que corrieron los ticks
+    int ticks = 0;              // Ticks de este trabajo (ver replay.h)
+
+    // Pose para dibujar: entre los dos ultimos ticks segun alpha
+    Player Interpolated() const {
+        Player player = current;
+        player.x = previous.x + (current.x - previous.x) * alpha;
+        player.y = previous.y + (current.y - previous.y) * alpha;
+        player.angle = previous.angle + (current.angle - previous.angle) * alpha;
+        return player;
+    }
+};
+
+// Un tick de movimiento: avanza o retrocede 3 unidades y gira 0.05 rad
+// (lo que antes se hacia por frame a 60 fps). El jugador es un circulo de
+// PLAYER_RADIUS celdas que desliza contra las paredes (ver movement.h).
+// Tocar el cubo morado lo quita del mapa (como cambio en edits) y gana el
+// nivel.
+inline void StepPlayer(Player& player, const PlayerInput& input, std::vector<CellEdit>& edits) {
+    const float moveSpeed = 3.0f;
+    float move = (input.forward ? moveSpeed : 0.0f) - (input.back ? moveSpeed : 0.0f);
+    if (move != 0.0f && !player.hasWon) {
+        MapView map = {worldMap, mapWidth, mapHeight, emptySpace};
+        float x = player.x / BLOCK_SIZE, y = player.y / BLOCK_SIZE;
+        MoveResult result = MoveCircle(map, x, y, PLAYER_RADIUS, cosf(player.angle) * move / BLOCK_SIZE, sinf(player.angle) * move / BLOCK_SIZE);
+        player.x = x * BLOCK_SIZE;
+        player.y = y * BLOCK_SIZE;
+        if (result.goalX >= 0) {
+            edits.push_back({result.goalX, result.goalY, 0});
+            player.hasWon = true;
+        }
+    }
+    if (player.hasWon) return;
+    if (input.turnLeft) player.angle -= 0.05f;
+    if (input.turnRight) player.angle += 0.05f;
+}
+
+class Simulation {
+public:
+    Simulation() : worker([this] { WorkerLoop(); }) {}
+
+    ~Simulation() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    // Empieza de cero en la pose dada (por ejemplo al cargar un nivel)
+    void Reset(const Player& player) {
+        Wait();
+        result = SimSnapshot();
+        result.previous = result.current = player;
+        accumulator = 0.0f;
+    }
+
+    // Lanza en el hilo de simulacion los ticks que caben en elapsed
+    // segundos (mas lo que sobro de frames anteriores) con esta entrada.
+    // Hay que llamar a Wait antes de lanzar otro.
+    void Start(const PlayerInput& input, float elapsed) {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobInput = input;
+        jobElapsed = elapsed;
+        busy = true;
+        wake.notify_one();
+    }
+
+    // Espera a que termine el ultimo trabajo lanzado y devuelve su
+    // resultado. Sin trabajo pendiente devuelve el resultado anterior; los
+    // cambios de celdas y los ticks de cada trabajo aparecen una sola vez.
+    const SimSnapshot& Wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return !busy; });
+        return result;
+    }
+
+private:
+    void Run() {
+        PROFILE_SCOPE("simulacion");
+        accumulator += jobElapsed;
+        int ticks = (int)(accumulator / SIM_TICK_SECONDS);
+        if (ticks > SIM_MAX_TICKS_PER_FRAME) {
+            ticks = SIM_MAX_TICKS_PER_FRAME;
+            accumulator = ticks * SIM_TICK_SECONDS;
+        }
+        accumulator -= ticks * SIM_TICK_SECONDS;
+
+        result.edits.clear();
+        result.input = jobInput;
+        result.ticks = ticks;
+        for (int i = 0; i < ticks; i++) {
+            result.previous = result.current;
+            StepPlayer(result.current, jobInput, result.edits);
+        }
+        result.won = result.current.hasWon;
+        result.alpha = accumulator / SIM_TICK_SECONDS;
+    }
+
+    void WorkerLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this] { return stopping || busy; });
+            if (stopping) return;
+            // Mientras busy el hilo principal no toca result ni el acumulador
+            lock.unlock();
+            Run();
+            lock.lock();
+            busy = false;
+            done.notify_all();
+        }
+    }
+
+    SimSnapshot result;
+    float accumulator = 0.0f;
+    PlayerInput jobInput = {};
+    float jobElapsed = 0.0f;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    bool busy = false;
+    bool stopping = false;
+    std::thread worker;     // Ultimo: arranca con todo lo demas ya construido
+};
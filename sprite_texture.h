@@ -0,0 +1,53 @@
+#pragma once
+
+// Textura de sprite preparada para el rasterizador por tramos: texeles por
+// columnas y, para cada columna, los tramos de filas opacas. Se calcula una
+// vez al crear la textura, asi que al dibujar no hay que revisar la
+// transparencia pixel por pixel: solo se recorren los tramos opacos.
+
+#include "raylib.h"
+#include <cstdint>
+#include <vector>
+
+// Filas [start, end) opacas de una columna de la textura
+struct SpriteSpan {
+    uint16_t start, end;
+};
+
+struct SpriteTexture {
+    int size = 0;
+    std::vector<Color> texels;          // size x size, por columnas
+    std::vector<SpriteSpan> spans;      // Tramos de todas las columnas, en orden
+    std::vector<int> columnSpans;       // size + 1: tramos de la columna x en [columnSpans[x], columnSpans[x + 1])
+
+    const Color* Column(int x) const { return texels.data() + (size_t)x * size; }
+};
+
+// Los pixeles casi negros son transparentes (asi se pintan las texturas de
+// los sprites)
+inline bool IsSpriteTexelOpaque(Color color) {
+    return color.r > 10 || color.g > 10 || color.b > 10;
+}
+
+// Prepara una textura de size x size pixeles en fila mayor
+inline SpriteTexture BuildSpriteTexture(const Color* pixels, int size) {
+    SpriteTexture texture;
+    texture.size = size;
+    texture.texels.resize((size_t)size * size);
+    texture.columnSpans.reserve(size + 1);
+    for (int x = 0; x < size; x++) {
+        texture.columnSpans.push_back((int)texture.spans.size());
+        int start = -1;
+        for (int y = 0; y <= size; y++) {
+            bool opaque = y < size && IsSpriteTexelOpaque(pixels[y * size + x]);
+            if (y < size) texture.texels[(size_t)x * size + y] = pixels[y * size + x];
+            if (opaque && start < 0) start = y;
+            if (!opaque && start >= 0) {
+                texture.spans.push_back({(uint16_t)start, (uint16_t)y});
+                start = -1;
+            }
+        }
+    }
+    texture.columnSpans.push_back((int)texture.spans.size());
+    return texture;
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+// Sprites del mundo en estructura de arreglos, indexados en una grilla
+// espacial uniforme, con el orden de profundidad del frame anterior
+// guardado para reordenar de forma incremental.
+//
+// Por frame solo se visitan las celdas de la grilla que toca el cono de
+// vision, asi que el costo crece con los sprites cercanos al cono y no con
+// el total de sprites del mapa.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+class SpriteSet {
+public:
+    // Datos por sprite (coordenadas de mundo)
+    std::vector<float> x, y;
+    std::vector<int> type;
+    std::vector<uint8_t> active;
+
+    // Profundidad del ultimo frame en que el sprite fue visible
+    std::vector<float> depth;
+
+    int Count() const { return (int)x.size(); }
+
+    void Clear() {
+        x.clear();
+        y.clear();
+        type.clear();
+        active.clear();
+        depth.clear();
+        inOrder.clear();
+        order.clear();
+        candidates.clear();
+        cellStart.clear();
+        cellItems.clear();
+        cursor.clear();
+        gridWidth = gridHeight = 0;
+    }
+
+    int Add(float spriteX, float spriteY, int spriteType) {
+        x.push_back(spriteX);
+        y.push_back(spriteY);
+        type.push_back(spriteType);
+        active.push_back(1);
+        depth.push_back(0);
+        inOrder.push_back(0);
+        return Count() - 1;
+    }
+
+    // Reparte los sprites en celdas de cellSize x cellSize unidades sobre
+    // [0, worldWidth) x [0, worldHeight). Hay que llamarla despues de agregar
+    // o mover sprites. Las celdas se guardan como listas contiguas (cada
+    // celda es un rango de cellItems) para recorrerlas sin punteros.
+    void BuildGrid(float worldWidth, float worldHeight, float size) {
+        cellSize = size;
+        gridWidth = std::max(1, (int)ceilf(worldWidth / cellSize));
+        gridHeight = std::max(1, (int)ceilf(worldHeight / cellSize));
+        RebuildGrid();
+    }
+
+    // Vuelve a repartir los sprites en la grilla de BuildGrid, sin reservar
+    // memoria (para sprites que se mueven en cada tick)
+    void RebuildGrid() {
+        cellStart.assign((size_t)gridWidth * gridHeight + 1, 0);
+        cellItems.resize(x.size());
+
+        for (int i = 0; i < Count(); i++) cellStart[CellOf(i) + 1]++;
+        for (size_t c = 1; c < cellStart.size(); c++) cellStart[c] += cellStart[c - 1];
+        cursor.assign(cellStart.begin(), cellStart.end() - 1);
+        for (int i = 0; i < Count(); i++) cellItems[cursor[CellOf(i)]++] = i;
+    }
+
+    // Llama a visit(i) para cada sprite de las celdas que toca el triangulo
+    // (px[k], py[k]) agrandado en margin unidades en cada direccion
+    template <class Visit>
+    void ForEachInTriangle(const float* px, const float* py, float margin, Visit visit) const {
+        if (cellStart.empty()) return;
+        float minY = std::min({py[0], py[1], py[2]}) - margin;
+        float maxY = std::max({py[0], py[1], py[2]}) + margin;
+        int row0 = std::max(0, (int)floorf(minY / cellSize));
+        int row1 = std::min(gridHeight - 1, (int)floorf(maxY / cellSize));
+
+        for (int row = row0; row <= row1; row++) {
+            // Extension en X del triangulo dentro de la franja de la fila
+            float bandMinX, bandMaxX;
+            if (!TriangleBandX(px, py, row * cellSize - margin, (row + 1) * cellSize + margin, bandMinX, bandMaxX)) continue;
+            int col0 = std::max(0, (int)floorf((bandMinX - margin) / cellSize));
+            int col1 = std::min(gridWidth - 1, (int)floorf((bandMaxX + margin) / cellSize));
+            for (int col = col0; col <= col1; col++) {
+                int cell = row * gridWidth + col;
+                for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++) visit(cellItems[k]);
+            }
+        }
+    }
+
+    // Marca el sprite i como visible en este frame con su profundidad
+    void MarkVisible(int i, float spriteDepth) {
+        depth[i] = spriteDepth;
+        candidates.push_back(i);
+    }
+
+    // Ordena los sprites marcados desde el ultimo SortVisible, del mas lejano
+    // al mas cercano. Parte del orden del frame anterior: los que siguen
+    // visibles conservan su posicion relativa y casi siempre ya estan en
+    // orden, asi que una insercion basta; los nuevos se ordenan aparte y se
+    // mezclan. Si la camara salto y el orden viejo ya no sirve, se usa
+    // std::sort sobre los indices.
+    const std::vector<int>& SortVisible() {
+        // Conservar el orden viejo de los que siguen visibles
+        for (int i : candidates) inOrder[i] |= 2;
+        size_t kept = 0;
+        for (int i : order) {
+            if (inOrder[i] & 2) order[kept++] = i;
+            else inOrder[i] = 0;
+        }
+        order.resize(kept);
+        for (int i : candidates) {
+            if (inOrder[i] == 2) order.push_back(i);
+            inOrder[i] = 1;
+        }
+        candidates.clear();
+
+        auto farther = [this](int a, int b) { return depth[a] > depth[b]; };
+        size_t shifts = 0;
+        size_t budget = 8 * kept + 64;
+        for (size_t j = 1; j < kept && shifts <= budget; j++) {
+            int item = order[j];
+            size_t k = j;
+            for (; k > 0 && farther(item, order[k - 1]); k--, shifts++) order[k] = order[k - 1];
+            order[k] = item;
+        }
+        if (shifts > budget) {
+            std::sort(order.begin(), order.end(), farther);
+        } else {
+            std::sort(order.begin() + kept, order.end(), farther);
+            std::inplace_merge(order.begin(), order.begin() + kept, order.end(), farther);
+        }
+        return order;
+    }
+
+private:
+    float cellSize = 1;
+    int gridWidth = 0, gridHeight = 0;
+    std::vector<int> cellStart;     // gridWidth * gridHeight + 1
+    std::vector<int> cellItems;     // Indices de sprites agrupados por celda
+    std::vector<int> cursor;        // Para RebuildGrid
+
+    std::vector<int> order;         // Visibles del ultimo frame, lejano a cercano
+    std::vector<uint8_t> inOrder;   // 1 = esta en order; 2 = marcado en este frame
+    std::vector<int> candidates;
+
+    int CellOf(int i) const {
+        int col = std::min(std::max((int)(x[i] / cellSize), 0), gridWidth - 1);
+        int row = std::min(std::max((int)(y[i] / cellSize), 0), gridHeight - 1);
+        return row * gridWidth + col;
+    }
+
+    // Recorta el triangulo a la franja lo <= y <= hi y devuelve el rango en X
+    // de lo que queda (Sutherland-Hodgman con las dos rectas horizontales)
+    static bool TriangleBandX(const float* px, const float* py, float lo, float hi, float& minX, float& maxX) {
+        float ax[8], ay[8], bx[8], by[8];
+        int count = 3;
+        for (int k = 0; k < 3; k++) {
+            ax[k] = px[k];
+            ay[k] = py[k];
+        }
+        count = ClipHalfPlane(ax, ay, count, lo, 1.0f, bx, by);
+        count = ClipHalfPlane(bx, by, count, hi, -1.0f, ax, ay);
+        if (count == 0) return false;
+        minX = maxX = ax[0];
+        for (int k = 1; k < count; k++) {
+            minX = std::min(minX, ax[k]);
+            maxX = std::max(maxX, ax[k]);
+        }
+        return true;
+    }
+
+    // Conserva la parte del poligono con sign * (y - limit) >= 0
+    static int ClipHalfPlane(const float* inX, const float* inY, int count, float limit, float sign, float* outX, float* outY) {
+        int out = 0;
+        for (int k = 0; k < count; k++) {
+            int next = (k + 1) % count;
+            float d0 = sign * (inY[k] - limit);
+            float d1 = sign * (inY[next] - limit);
+            if (d0 >= 0) {
+                outX[out] = inX[k];
+                outY[out] = inY[k];
+                out++;
+            }
+            if ((d0 >= 0) != (d1 >= 0)) {
+                float t = d0 / (d0 - d1);
+                outX[out] = inX[k] + t * (inX[next] - inX[k]);
+                outY[out] = inY[k] + t * (inY[next] - inY[k]);
+                out++;
+            }
+        }
+        return out;
+    }
+};
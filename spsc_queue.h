@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Cola circular sin bloqueos de un productor y un consumidor.
+//
+// Cada indice lo escribe un solo hilo (head el consumidor, tail el
+// productor) y el otro solo lo lee, asi que bastan loads y stores
+// atomicos con acquire/release: ningun lado espera nunca al otro. Capacity
+// debe ser potencia de dos; los indices crecen sin limite y se reducen con
+// una mascara.
+template <class T, uint32_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity debe ser potencia de dos");
+
+public:
+    // Solo el productor. Devuelve false (y descarta el elemento) si esta llena.
+    bool Push(const T& item) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == Capacity) return false;
+        items[t & (Capacity - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Solo el consumidor. Devuelve false si esta vacia.
+    bool Pop(T& item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        item = items[h & (Capacity - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T items[Capacity];
+    alignas(64) std::atomic<uint32_t> head{0};
+    alignas(64) std::atomic<uint32_t> tail{0};
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+// Atlas de texturas de pared guardadas por columnas (column-major) con
+// todos sus niveles de mipmap en un solo arreglo.
+//
+// Una tira vertical de pared recorre una sola columna de la textura, asi
+// que guardarla por columnas hace que esa lectura sea contigua en memoria.
+// El nivel de mipmap se elige por la altura proyectada de la pared: una
+// pared lejana de pocos pixeles lee un nivel chico y ya promediado en vez
+// de saltar texeles del nivel completo (menos fallos de cache y menos
+// aliasing).
+
+#include "raylib.h"
+#include <vector>
+
+class TextureAtlas {
+public:
+    // Agrega una textura cuadrada de size x size texeles en fila mayor (el
+    // formato de CreateCubeTexture). size debe ser potencia de dos. Devuelve
+    // el id de la textura en el atlas.
+    int Add(const Color* pixels, int size) {
+        Entry entry;
+        entry.size = size;
+        entry.levels = 0;
+
+        // Nivel 0: transponer a columnas
+        std::vector<Color> level((size_t)size * size);
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) level[(size_t)x * size + y] = pixels[y * size + x];
+        }
+
+        // Cada nivel siguiente promedia bloques de 2x2 del anterior
+        int levelSize = size;
+        while (true) {
+            entry.offsets[entry.levels++] = texels.size();
+            texels.insert(texels.end(), level.begin(), level.end());
+            if (levelSize == 1 || entry.levels == MAX_LEVELS) break;
+
+            int next = levelSize / 2;
+            std::vector<Color> smaller((size_t)next * next);
+            for (int x = 0; x < next; x++) {
+                for (int y = 0; y < next; y++) {
+                    const Color& a = level[(size_t)(2 * x) * levelSize + 2 * y];
+                    const Color& b = level[(size_t)(2 * x) * levelSize + 2 * y + 1];
+                    const Color& c = level[(size_t)(2 * x + 1) * levelSize + 2 * y];
+                    const Color& d = level[(size_t)(2 * x + 1) * levelSize + 2 * y + 1];
+                    smaller[(size_t)x * next + y] = {
+                        (unsigned char)((a.r + b.r + c.r + d.r + 2) / 4),
+                        (unsigned char)((a.g + b.g + c.g + d.g + 2) / 4),
+                        (unsigned char)((a.b + b.b + c.b + d.b + 2) / 4),
+                        (unsigned char)((a.a + b.a + c.a + d.a + 2) / 4)
+                    };
+                }
+            }
+            level.swap(smaller);
+            levelSize = next;
+        }
+
+        entries.push_back(entry);
+        return (int)entries.size() - 1;
+    }
+
+    int Count() const { return (int)entries.size(); }
+
+    // Nivel de mipmap para una pared de wallHeight pixeles de alto: el mas
+    // chico que todavia tiene al menos un texel por pixel
+    int SelectLevel(int id, float wallHeight) const {
+        const Entry& entry = entries[id];
+        int level = 0;
+        while (level + 1 < entry.levels && (entry.size >> (level + 1)) >= wallHeight) level++;
+        return level;
+    }
+
+    int LevelSize(int id, int level) const { return entries[id].size >> level; }
+
+    // Columna texX del nivel dado: LevelSize texeles contiguos de arriba a abajo
+    const Color* Column(int id, int level, int texX) const {
+        const Entry& entry = entries[id];
+        return texels.data() + entry.offsets[level] + (size_t)texX * (entry.size >> level);
+    }
+
+private:
+    static const int MAX_LEVELS = 16;
+
+    struct Entry {
+        int size;
+        int levels;
+        size_t offsets[MAX_LEVELS];
+    };
+
+    std::vector<Entry> entries;
+    std::vector<Color> texels;
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pool de hilos persistente con robo de trabajo (work stealing).
+//
+// ParallelFor reparte las tareas [0, numTasks) en rangos contiguos, uno por
+// participante (los trabajadores y el hilo que llama). Cada uno consume su
+// rango desde el inicio y, cuando se queda sin trabajo, roba la mitad final
+// del rango de otro. El rango de cada participante vive en un solo entero
+// atomico de 64 bits (inicio en la parte baja, fin en la alta), asi que
+// consumir y robar son un compare-exchange sin bloqueos.
+class ThreadPool {
+public:
+    // numThreads cuenta tambien al hilo que llama a ParallelFor
+    explicit ThreadPool(int numThreads) {
+        if (numThreads < 1) numThreads = 1;
+        slots = std::vector<Slot>(numThreads);
+        for (int i = 1; i < numThreads; i++) {
+            workers.emplace_back([this, i] { WorkerLoop(i); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int ThreadCount() const { return (int)slots.size(); }
+
+    // Ejecuta task(i) para cada i en [0, numTasks) y regresa cuando todas
+    // terminaron. No es reentrante: una sola llamada activa a la vez.
+    void ParallelFor(int numTasks, const std::function<void(int)>& task) {
+        if (numTasks <= 0) return;
+        if (slots.size() == 1 || numTasks == 1) {
+            for (int i = 0; i < numTasks; i++) task(i);
+            return;
+        }
+
+        int participants = (int)slots.size();
+        for (int i = 0; i < participants; i++) {
+            uint32_t begin = (uint32_t)((int64_t)numTasks * i / participants);
+            uint32_t end = (uint32_t)((int64_t)numTasks * (i + 1) / participants);
+            slots[i].range.store(Pack(begin, end), std::memory_order_relaxed);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            currentTask = &task;
+            remaining.store(numTasks, std::memory_order_relaxed);
+            busyWorkers = (int)workers.size();
+            generation++;
+        }
+        wake.notify_all();
+
+        RunTasks(0, task);
+
+        // Esperar a que todos los trabajadores salgan del trabajo actual
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return busyWorkers == 0; });
+        currentTask = nullptr;
+    }
+
+private:
+    struct Slot {
+        alignas(64) std::atomic<uint64_t> range{0};
+    };
+
+    static uint64_t Pack(uint32_t begin, uint32_t end) {
+        return ((uint64_t)end << 32) | begin;
+    }
+
+    // Toma la siguiente tarea del rango propio
+    bool PopLocal(int self, uint32_t& index) {
+        std::atomic<uint64_t>& range = slots[self].range;
+        uint64_t packed = range.load(std::memory_order_acquire);
+        while (true) {
+            uint32_t begin = (uint32_t)packed;
+            uint32_t end = (uint32_t)(packed >> 32);
+            if (begin >= end) return false;
+            if (range.compare_exchange_weak(packed, Pack(begin + 1, end), std::memory_order_acq_rel)) {
+                index = begin;
+                return true;
+            }
+        }
+    }
+
+    // Roba la mitad final del rango de otro participante hacia el propio
+    bool Steal(int self) {
+        int participants = (int)slots.size();
+        for (int offset = 1; offset < participants; offset++) {
+            std::atomic<uint64_t>& victim = slots[(self + offset) % participants].range;
+            uint64_t packed = victim.load(std::memory_order_acquire);
+            while (true) {
+                uint32_t begin = (uint32_t)packed;
+                uint32_t end = (uint32_t)(packed >> 32);
+                if (begin >= end) break;
+                uint32_t count = end - begin;
+                uint32_t split = end - (count + 1) / 2;
+                if (victim.compare_exchange_weak(packed, Pack(begin, split), std::memory_order_acq_rel)) {
+                    // Nadie modifica un rango vacio, asi que basta un store
+                    slots[self].range.store(Pack(split, end), std::memory_order_release);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void RunTasks(int self, const std::function<void(int)>& task) {
+        while (remaining.load(std::memory_order_acquire) > 0) {
+            uint32_t index;
+            if (PopLocal(self, index)) {
+                task((int)index);
+                remaining.fetch_sub(1, std::memory_order_acq_rel);
+            } else if (!Steal(self)) {
+                // Las tareas restantes ya estan en manos de otros hilos
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void WorkerLoop(int self) {
+        uint64_t seenGeneration = 0;
+        while (true) {
+            const std::function<void(int)>* task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+                if (stopping) return;
+                seenGeneration = generation;
+                task = currentTask;
+            }
+
+            RunTasks(self, *task);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busyWorkers == 0) done.notify_one();
+        }
+    }
+
+    std::vector<Slot> slots;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(int)>* currentTask = nullptr;
+    std::atomic<int> remaining{0};
+    int busyWorkers = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+// Capas retenidas de la interfaz.
+//
+// El mini-mapa, el HUD y las pantallas de menu y victoria casi nunca
+// cambian de un frame al siguiente. Cada una se dibuja una vez en una
+// textura (CachedLayer) y en cada frame solo se copia esa textura; se
+// vuelve a dibujar cuando cambia su clave: la version del mapa, el nivel,
+// el texto. Lo que se mueve (el jugador en el mini-mapa) se dibuja encima
+// en cada frame.
+
+#include "raylib.h"
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+
+const int MINIMAP_SIZE = 60;        // Lado del mini-mapa en pixeles
+const int MINIMAP_MAX_CELLS = 30;   // En mapas mas grandes se muestra una ventana de este lado alrededor del jugador
+
+class CachedLayer {
+public:
+    // La capa no se dibujo todavia, o se dibujo para otra clave o tamaño
+    bool Stale(int width, int height, uint64_t key) const {
+        return !valid || key != currentKey || target.texture.width != width || target.texture.height != height;
+    }
+
+    // Empieza a dibujar la capa desde cero (fondo transparente); terminar
+    // con End. Se puede llamar entre BeginDrawing y EndDrawing.
+    void Begin(int width, int height, uint64_t key) {
+        if (target.id == 0 || target.texture.width != width || target.texture.height != height) {
+            if (target.id != 0) UnloadRenderTexture(target);
+            target = LoadRenderTexture(width, height);
+        }
+        currentKey = key;
+        valid = true;
+        BeginTextureMode(target);
+        ClearBackground(BLANK);
+    }
+
+    void End() { EndTextureMode(); }
+
+    // Copia la capa a la pantalla con la esquina superior izquierda en (x, y)
+    void Draw(int x, int y) const {
+        // Las render textures quedan invertidas en Y
+        Rectangle source = {0, 0, (float)target.texture.width, -(float)target.texture.height};
+        DrawTextureRec(target.texture, source, {(float)x, (float)y}, WHITE);
+    }
+
+    void Unload() {
+        if (target.id != 0) UnloadRenderTexture(target);
+        target = RenderTexture2D{};
+        valid = false;
+    }
+
+private:
+    RenderTexture2D target = {};
+    uint64_t currentKey = 0;
+    bool valid = false;
+};
+
+// Celdas que muestra el mini-mapa: todo el mapa si cabe, o una ventana de
+// MINIMAP_MAX_CELLS celdas de lado centrada en (cellX, cellY) y dentro del mapa
+struct MinimapWindow {
+    int originX, originY;
+    int cellsX, cellsY;
+};
+
+inline MinimapWindow MinimapWindowAround(float cellX, float cellY, int mapWidth, int mapHeight) {
+    MinimapWindow window;
+    window.cellsX = std::min(mapWidth, MINIMAP_MAX_CELLS);
+    window.cellsY = std::min(mapHeight, MINIMAP_MAX_CELLS);
+    window.originX = std::clamp((int)cellX - window.cellsX / 2, 0, mapWidth - window.cellsX);
+    window.originY = std::clamp((int)cellY - window.cellsY / 2, 0, mapHeight - window.cellsY);
+    return window;
+}
+
+// Clave de una capa a partir de varios valores (FNV-1a)
+inline uint64_t LayerKey(std::initializer_list<uint64_t> values) {
+    uint64_t key = 1469598103934665603ull;
+    for (uint64_t value : values) key = (key ^ value) * 1099511628211ull;
+    return key;
+}